@@ -20,9 +20,26 @@
 #define SHARED_CIRCULAR_BUFFER_HH_
 
 #include <stdint.h>
+#include <string.h>
 
 typedef uint16_t BufSizeType;
 
+#ifdef CIRCULAR_BUFFER_STATS
+/// Number of histogram bins used to record buffer fill levels
+#define CIRCULAR_BUFFER_HISTOGRAM_BINS 8
+
+/// Occupancy statistics kept by each circular buffer when the firmware is
+/// built with CIRCULAR_BUFFER_STATS.  Counters saturate rather than wrap.
+struct CircularBufferStats {
+	BufSizeType high_water;   ///< Highest fill level since the last reset
+	BufSizeType low_water;    ///< Lowest fill level left by a pop since the last reset
+	uint16_t overflow_count;  ///< Number of pushes dropped because the buffer was full
+	uint16_t underflow_count; ///< Number of pops made on too little data
+	/// Fill level left by each pop, in eighths of the buffer size
+	uint16_t histogram[CIRCULAR_BUFFER_HISTOGRAM_BINS];
+};
+#endif
+
 /// A simple, reliable circular buffer implementation.
 /// This implementation does not offer any protection from
 /// interrupts and code writing over each other!  You must
@@ -32,19 +49,78 @@ template<typename T>
 class CircularBufferTempl {
 public:
 	typedef T BufDataType;
-private:
+protected:
 	const BufSizeType size; /// Size of this buffer
 	volatile BufSizeType length; /// Current length of valid buffer data
 	volatile BufSizeType start; /// Current start point of valid bufffer data
 	BufDataType* const data; /// Pointer to buffer data
 	volatile bool overflow; /// Overflow indicator
 	volatile bool underflow; /// Underflow indicator
+#ifdef CIRCULAR_BUFFER_STATS
+	CircularBufferStats stats; /// Occupancy statistics
+#endif
+
+	/// Record the fill level after data has been added
+	inline void notePush() {
+#ifdef CIRCULAR_BUFFER_STATS
+		if (length > stats.high_water) {
+			stats.high_water = length;
+		}
+#endif
+	}
+	/// Record the fill level after data has been removed
+	inline void notePop() {
+#ifdef CIRCULAR_BUFFER_STATS
+		if (length < stats.low_water) {
+			stats.low_water = length;
+		}
+		uint8_t bin = ((uint32_t)length * CIRCULAR_BUFFER_HISTOGRAM_BINS) / (size + 1);
+		if (stats.histogram[bin] != 0xffff) {
+			stats.histogram[bin]++;
+		}
+#endif
+	}
+	/// Flag a push that did not fit
+	inline void noteOverflow() {
+		overflow = true;
+#ifdef CIRCULAR_BUFFER_STATS
+		if (stats.overflow_count != 0xffff) {
+			stats.overflow_count++;
+		}
+#endif
+	}
+	/// Flag a pop that asked for more than was available
+	inline void noteUnderflow() {
+		underflow = true;
+#ifdef CIRCULAR_BUFFER_STATS
+		if (stats.underflow_count != 0xffff) {
+			stats.underflow_count++;
+		}
+#endif
+	}
 public:
 	CircularBufferTempl(BufSizeType size_in, BufDataType* data_in) :
 		size(size_in), length(0), start(0), data(data_in), overflow(false),
 				underflow(false) {
+#ifdef CIRCULAR_BUFFER_STATS
+		resetStats();
+#endif
 	}
 
+#ifdef CIRCULAR_BUFFER_STATS
+	/// Restart the occupancy statistics from the current fill level, for
+	/// instance at the start of a build.
+	inline void resetStats() {
+		memset(&stats, 0, sizeof(stats));
+		stats.high_water = length;
+		stats.low_water = length;
+	}
+	/// Get the occupancy statistics
+	inline const CircularBufferStats& getStats() const {
+		return stats;
+	}
+#endif
+
 	/// Reset the buffer to its empty state.  All data in
 	/// the buffer will be (effectively) lost.
 	inline void reset() {
@@ -58,19 +134,21 @@ public:
 		if (length < size) {
 			operator[](length) = b;
 			length++;
+			notePush();
 		} else {
-			overflow = true;
+			noteOverflow();
 		}
 	}
 	/// Pop a byte off the head of the buffer
 	inline BufDataType pop() {
 		if (isEmpty()) {
-			underflow = true;
+			noteUnderflow();
 			return BufDataType();
 		}
 		const BufDataType& popped_byte = operator[](0);
 		start = (start + 1) % size;
 		length--;
+		notePop();
 		return popped_byte;
 	}
 
@@ -79,11 +157,78 @@ public:
 	/// set the underflow flag.
 	inline void pop(BufSizeType sz) {
 		if (length < sz) {
-			underflow = true;
+			noteUnderflow();
 			sz = length;
 		}
 		start = (start + sz) % size;
 		length -= sz;
+		notePop();
+	}
+
+	/// Append a block of data to the tail of the buffer, copying it in at
+	/// most two segments.  If there is not enough room, append what fits
+	/// and set the overflow flag.
+	/// \param[in] src Data to append
+	/// \param[in] n Number of entries to append
+	/// \return Number of entries appended
+	inline BufSizeType push_n(const BufDataType* src, BufSizeType n) {
+		if (n > size - length) {
+			noteOverflow();
+			n = size - length;
+		}
+		BufSizeType tail = start + length;
+		if (tail >= size) {
+			tail -= size;
+		}
+		BufSizeType first = size - tail;
+		if (first > n) {
+			first = n;
+		}
+		memcpy(data + tail, src, first * sizeof(BufDataType));
+		memcpy(data, src + first, (n - first) * sizeof(BufDataType));
+		length += n;
+		notePush();
+		return n;
+	}
+
+	/// Pop a block of data off the head of the buffer, copying it out in at
+	/// most two segments.  If there are not enough entries, pop what we can
+	/// and set the underflow flag.
+	/// \param[out] dst Destination for the popped data
+	/// \param[in] n Number of entries to pop
+	/// \return Number of entries popped
+	inline BufSizeType pop_n(BufDataType* dst, BufSizeType n) {
+		if (n > length) {
+			noteUnderflow();
+			n = length;
+		}
+		BufSizeType first = size - start;
+		if (first > n) {
+			first = n;
+		}
+		memcpy(dst, data + start, first * sizeof(BufDataType));
+		memcpy(dst + first, data, (n - first) * sizeof(BufDataType));
+		start += n;
+		if (start >= size) {
+			start -= size;
+		}
+		length -= n;
+		notePop();
+		return n;
+	}
+
+	/// Get the longest run of data at the head of the buffer that is
+	/// contiguous in the underlying storage, so that it can be read in
+	/// place.  Follow with pop(sz) to consume what was used; a second call
+	/// then returns the part that wrapped around, if any.
+	/// \param[out] len Number of entries available at the returned pointer
+	/// \return Pointer to the head of the buffer
+	inline BufDataType* peek_contiguous(BufSizeType& len) {
+		len = size - start;
+		if (len > length) {
+			len = length;
+		}
+		return data + start;
 	}
 
 	/// Get the length of the buffer
@@ -115,12 +260,74 @@ public:
 	}
 };
 
+/// A circular buffer whose size is fixed at compile time, with the storage
+/// held inline.  When the size is a power of two, indices wrap with a mask
+/// instead of the (software, on AVR) division that the general buffer needs.
+/// It can still be passed anywhere a #CircularBufferTempl is expected; only
+/// calls made through the derived type use the faster indexing.
+template<typename T, BufSizeType N>
+class StaticCircularBuffer : public CircularBufferTempl<T> {
+public:
+	typedef T BufDataType;
+private:
+	BufDataType storage[N]; /// Buffer data
+protected:
+	/// Wrap an index into the buffer.  N is a constant, so the test is
+	/// resolved by the compiler.
+	static inline BufSizeType wrap(BufSizeType index) {
+		return ((N & (N - 1)) == 0) ? (index & (N - 1)) : (index % N);
+	}
+public:
+	StaticCircularBuffer() : CircularBufferTempl<T>(N, storage) {
+	}
+
+	/// Append a byte to the tail of the buffer
+	inline void push(BufDataType b) {
+		if (this->length < N) {
+			operator[](this->length) = b;
+			this->length++;
+			this->notePush();
+		} else {
+			this->noteOverflow();
+		}
+	}
+	/// Pop a byte off the head of the buffer
+	inline BufDataType pop() {
+		if (this->isEmpty()) {
+			this->noteUnderflow();
+			return BufDataType();
+		}
+		const BufDataType popped_byte = storage[this->start];
+		this->start = wrap(this->start + 1);
+		this->length--;
+		this->notePop();
+		return popped_byte;
+	}
+
+	/// Pop a number of bytes off the head of the buffer.  If there
+	/// are not enough bytes to complete the pop, pop what we can and
+	/// set the underflow flag.
+	inline void pop(BufSizeType sz) {
+		if (this->length < sz) {
+			this->noteUnderflow();
+			sz = this->length;
+		}
+		this->start = wrap(this->start + sz);
+		this->length -= sz;
+		this->notePop();
+	}
+
+	/// Read the buffer directly
+	inline BufDataType& operator[](BufSizeType index) {
+		return storage[wrap(index + this->start)];
+	}
+};
+
 typedef CircularBufferTempl<uint8_t> CircularBuffer;
 typedef CircularBufferTempl<uint16_t> CircularBuffer16;
 typedef CircularBufferTempl<uint32_t> CircularBuffer32;
 
 #define DEFINE_BUFFER(name,dtype,size) \
-dtype name##_data[size]; \
-CircularBufferTempl<dtype> name(size,name##_data);
+StaticCircularBuffer<dtype,size> name;
 
 #endif // SHARED_CIRCULAR_BUFFER_HH_
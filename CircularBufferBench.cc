@@ -0,0 +1,70 @@
+/// Host microbenchmark comparing #StaticCircularBuffer with the general
+/// #CircularBufferTempl.  It is not part of the firmware; build and run it on
+/// the host with:
+///
+///     g++ -O2 -DHOST_TEST -o cbbench CircularBufferBench.cc && ./cbbench
+///
+/// Each case pushes and pops bytes through a buffer that stays partly full,
+/// so the indices wrap many times, and checks that the data comes out in
+/// order.  The times only compare the two index calculations; on AVR the
+/// division the general buffer uses is done in software, so the gap there is
+/// much wider than on the host.
+
+#ifdef HOST_TEST
+
+#include <stdio.h>
+#include <time.h>
+#include "CircularBuffer.hh"
+
+static const BufSizeType SIZE = 64;
+static const uint32_t ROUNDS = 20000000UL;
+
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// Push and pop through a buffer, keeping it half full
+/// \return Number of bytes that came out of order
+template<typename B>
+static uint32_t run(B& buf, double& seconds) {
+	uint32_t errors = 0;
+	uint8_t in = 0, out = 0;
+	for (BufSizeType i = 0; i < SIZE / 2; i++) {
+		buf.push(in++);
+	}
+	double start = now();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		buf.push(in++);
+		// read through the index operator as well as pop
+		if (buf[0] != out) {
+			errors++;
+		}
+		if (buf.pop() != out++) {
+			errors++;
+		}
+	}
+	seconds = now() - start;
+	if (buf.hasOverflow() || buf.hasUnderflow()) {
+		errors++;
+	}
+	return errors;
+}
+
+int main() {
+	uint8_t storage[SIZE];
+	CircularBuffer general(SIZE, storage);
+	StaticCircularBuffer<uint8_t, SIZE> fixed;
+
+	double general_s, fixed_s;
+	uint32_t errors = run(general, general_s);
+	errors += run(fixed, fixed_s);
+
+	printf("CircularBuffer         %6.2f ns/op\n", general_s * 1e9 / ROUNDS);
+	printf("StaticCircularBuffer   %6.2f ns/op\n", fixed_s * 1e9 / ROUNDS);
+	printf("%s (%u errors)\n", errors ? "FAIL" : "PASS", (unsigned)errors);
+	return errors ? 1 : 0;
+}
+
+#endif // HOST_TEST
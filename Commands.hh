@@ -117,6 +117,76 @@
 #define HOST_CMD_STREAM_VERSION    157
 #define HOST_CMD_DEBUG_ECHO        0x70
 
+// Link benchmark form of the debug echo, available when the firmware is built
+// with LINK_BENCHMARK.  The request is the command byte, a uint32 host timestamp
+// and optional padding.  The response is RC_OK followed by five uint32 values:
+// the host timestamp, the board time the start byte and the last byte were
+// received, the time spent in the receive interrupt for the packet, and the
+// time from packet completion to the response being built.  The response is
+// padded to the length of the request.  A request too short to hold the
+// timestamp gets RC_PACKET_LENGTH.  LinkBenchmark.cc is the host tool that
+// drives it.
+#define HOST_CMD_DEBUG_ECHO_TIMED  0x71
+
+// Control the host packet log, available when the firmware is built with
+// PACKET_LOG.  The byte after the command selects the operation:
+//   0: stop recording
+//   1: clear the log and start recording
+//   2: stop recording and read log bytes; the response is RC_OK followed by
+//      up to 31 bytes of the log.  An empty response means the log is drained.
+//   3: read the loss counters; the response is RC_OK followed by the uint16
+//      number of records discarded to make room and the uint16 number of host
+//      bytes lost to a full receive queue with HOST_FLOW_CONTROL.
+// See PacketLog.hh for the record format.
+#define HOST_CMD_PACKET_LOG        0x72
+
+// Read the occupancy statistics of a circular buffer, available when the
+// firmware is built with CIRCULAR_BUFFER_STATS.  The byte after the command
+// selects the buffer (0 is the command buffer); bit 7 of it also restarts the
+// statistics after they are read.  The response is RC_OK followed by the
+// uint16 high-water mark, low-water mark, overflow count and underflow count,
+// then the eight uint16 fill level histogram bins (see CircularBufferStats).
+#define HOST_CMD_GET_BUFFER_STATS  0x73
+
+// Read the main loop profile, available when the firmware is built with
+// PROFILER.  The byte after the command selects the slice (see
+// profiler::Slice); bit 7 of it also clears all totals after they are read.
+// The response is RC_OK followed by the uint32 total microseconds, the uint32
+// call count and the uint32 longest call in microseconds.  A task that yields
+// counts one call per run, and its longest call is its longest slice.
+#define HOST_CMD_GET_PROFILE       0x74
+
+// Start a relay autotune of a heater's PID gains (see Heater::startAutotune).
+// The byte after the command selects the heater: the tool index for an
+// extruder, or 0xff for the build platform.  It is followed by the uint16
+// target temperature to oscillate around.  The response is RC_OK.  Poll the
+// heater's set temperature to see when tuning is over; it returns to zero.
+#define HOST_CMD_PID_AUTOTUNE      0x75
+
+// Get the estimated time until every heater that is heating up reaches its
+// target.  The response is RC_OK followed by a uint16 number of seconds: 0 if
+// all heaters are ready, or 0xffff if any of them can not be estimated yet.
+// The per-heater estimates come from Heater::getHeatupEta(), combined with
+// HeatupEta::combine().
+#define HOST_CMD_GET_HEATUP_ETA    0x76
+
+// Control a heater's telemetry recorder, available when the firmware is built
+// with HEATER_TELEMETRY.  The byte after the command selects the heater, as for
+// HOST_CMD_PID_AUTOTUNE, and the next byte the operation:
+//   0: stop recording
+//   1: clear the recorder and start recording
+//   2: read records; the response is RC_OK followed by as many whole
+//      TELEMETRY_RECORD_SIZE byte records as fit.  An empty response means
+//      the recorder is drained.  Recording continues.
+//   3: get the uint16 count of records discarded since recording started
+//   4: clear the recorder and start recording, also writing every record to
+//      the SD card file named by the null terminated string that follows.
+//      The response is RC_OK followed by a byte that is 1 if the file was
+//      opened, else 0; operation 0 closes it.  Only one heater can log at a
+//      time.
+// See HeaterTelemetry.hh for the record layout.
+#define HOST_CMD_HEATER_TELEMETRY  0x77
+
 // These are our query commands from the host
 #define SLAVE_CMD_VERSION                0
 #define SLAVE_CMD_INIT                   1
@@ -157,6 +227,11 @@
 #define SLAVE_CMD_GET_TOOL_STATUS       36
 #define SLAVE_CMD_GET_PID_STATE         37
 #define SLAVE_CMD_LIGHT_INDICATOR_LED   40
+// Get the tool or platform temperature with its fraction of a degree.  The
+// response is RC_OK followed by the int16 temperature in sixteenths of a degree
+// Celsius (see TEMPERATURE_FRACTION_BITS), as the heater's PID sees it.
+#define SLAVE_CMD_GET_TEMP_SIXTEENTHS           41
+#define SLAVE_CMD_GET_PLATFORM_TEMP_SIXTEENTHS  42
 
 
 enum SoftwareVariant{
@@ -0,0 +1,108 @@
+#ifndef COMPACT_TIMEOUT_HH_
+#define COMPACT_TIMEOUT_HH_
+
+#include <stdint.h>
+#include "Types.hh"
+#include "ExtendedClock.hh"
+
+/// A one-shot timer with the same interface as #Timeout, for objects that need
+/// many timers but not microsecond accuracy.  It counts ticks of \a Resolution
+/// milliseconds, which must be 1 or 100, of the shared #extendedclock
+/// millisecond or tenth of a second count, and stores its deadline and
+/// duration as \a Width integers, so a 16 bit timer takes five bytes of RAM
+/// instead of fifteen.
+///
+/// A timeout elapses between its duration and one tick later.  The duration
+/// must be less than half the range of \a Width in ticks; see the typedefs
+/// below for the limits of the common cases.
+/// \ingroup SoftwareLibraries
+template <uint16_t Resolution, typename Width>
+class TimeoutT {
+private:
+	/// Half the range of Width; a tick difference at least this large is
+	/// treated as negative
+	const static Width HALF_RANGE = (Width)(((Width)~(Width)0 >> 1) + 1);
+
+	typedef char resolution_must_be_a_clock_tick[(Resolution == 1 || Resolution == 100) ? 1 : -1];
+
+	const static uint8_t ACTIVE = 1 << 0;   ///< Counting down
+	const static uint8_t ELAPSED = 1 << 1;  ///< Has elapsed
+	const static uint8_t PAUSED = 1 << 2;   ///< Paused
+
+	uint8_t flags;          ///< Combination of the flags above
+	Width deadline;         ///< Tick at which it elapses, or the ticks remaining while paused
+	Width duration;         ///< Length of the current cycle, in ticks
+
+	/// The clock keeps both tick counts, so reading either is only a copy
+	static Width now() {
+		return (Width)(Resolution == 1 ? extendedclock::getMillis() : extendedclock::getTenths());
+	}
+
+public:
+	/// Instantiate a new timeout object.
+	TimeoutT() : flags(0) {}
+
+	/// Start a new timeout cycle that will elapse after the given amount of time.
+	/// \param [in] duration_micros Microseconds until the timeout cycle should elapse.
+	void start(micros_t duration_micros) {
+		const micros_t tick_micros = (micros_t)Resolution * 1000;
+		// Round up, and add a tick because the current one is partly over
+		duration = (Width)((duration_micros + tick_micros - 1) / tick_micros + 1);
+		deadline = now() + duration;
+		flags = ACTIVE;
+	}
+
+	/// Test whether the current timeout cycle has elapsed.
+	/// \return True if the timeout has elapsed.
+	bool hasElapsed() {
+		if (flags == ACTIVE && (Width)(now() - deadline) < HALF_RANGE) {
+			flags = ELAPSED;
+		}
+		return (flags & ELAPSED) != 0;
+	}
+
+	/// \return True if the timeout is still running.
+	bool isActive() const { return (flags & ACTIVE) != 0; }
+
+	/// Stop the current timeout.
+	void abort() { flags &= ~ACTIVE; }
+
+	/// Clear the timeout so it can be used again
+	void clear() { flags &= ~ELAPSED; }
+
+	/// pause the timer
+	/// while paused, the timer will not increment
+	/// \param pause_in true to pause, false to unpause
+	void pause(bool pause_in) {
+		if (((flags & PAUSED) != 0) == pause_in) {
+			return;
+		}
+		if (pause_in) {
+			flags |= PAUSED;
+			// keep the time remaining, which may already be "negative"
+			deadline = deadline - now();
+		} else {
+			flags &= ~PAUSED;
+			deadline = now() + deadline;
+		}
+	}
+
+	/// get the microseconds elapsed since starting the timer
+	/// \return microseconds elapsed, to the resolution of the timer
+	micros_t getCurrentElapsed() {
+		if (!(flags & ACTIVE)) {
+			return 0;
+		}
+		Width remaining = (flags & PAUSED) ? deadline : (Width)(deadline - now());
+		Width elapsed = duration - remaining;
+		return (micros_t)elapsed * Resolution * 1000;
+	}
+};
+
+/// Millisecond timer for periods of up to 32 seconds
+typedef TimeoutT<1, uint16_t> MillisTimeout;
+
+/// 100 millisecond timer for periods of up to 54 minutes
+typedef TimeoutT<100, uint16_t> CoarseTimeout;
+
+#endif // COMPACT_TIMEOUT_HH_
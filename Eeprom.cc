@@ -162,13 +162,32 @@ float getEepromFixed16(const uint16_t location, const float default_value) {
       return ((float)data[0]) + ((float)data[1])/256.0;
 }
 
+/// Fetch a fixed 16 value from eeprom without converting it; the integer part
+/// is in the high byte of the result
+uint16_t getEepromFixed16Raw(const uint16_t location, const uint16_t default_value) {
+    uint8_t data[2];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){  
+        eeprom_read_block(data,(const uint8_t*)location,2);
+		}
+    if (data[0] == 0xff && data[1] == 0xff) return default_value;
+      return ((uint16_t)data[0] << 8) | data[1];
+}
 
-/// Write a fixed 16 value to eeprom
+
+/// Write a fixed 16 value to eeprom, rounded to the nearest 1/256 as
+/// PID::toFixed16() does.  0xFFFF reads back as erased, so larger values are
+/// stored as 0xFEFF.
 void setEepromFixed16(const uint16_t location, const float new_value)
 {
+    uint16_t fixed = 0;
+    if (new_value >= 0xfeff / 256.0) {
+      fixed = 0xfeff;
+    } else if (new_value > 0) {
+      fixed = (uint16_t)(new_value * 256.0 + 0.5);
+    }
     uint8_t data[2];
-    data[0] = (uint8_t)new_value;
-    data[1] = (int)((new_value - data[0])*256.0);
+    data[0] = fixed >> 8;
+    data[1] = fixed & 0xff;
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE){  
       eeprom_write_block(data,(uint8_t*)location,2);
     }
@@ -0,0 +1,65 @@
+#ifdef EXTENDED_CLOCK
+
+#include "ExtendedClock.hh"
+#ifdef __AVR__
+#include <util/atomic.h>
+#else
+// Host builds of the clock tests are single threaded
+#define ATOMIC_BLOCK(type)
+#endif
+
+namespace extendedclock {
+
+micros_t last_micros = 0;	///< Board clock at the last tick
+uint32_t wraps = 0;		///< Number of times the board clock has wrapped
+
+uint32_t millis = 0;		///< Milliseconds since boot
+uint16_t millis_micros = 0;	///< Microseconds counted towards the next millisecond
+uint32_t tenths = 0;		///< Tenths of a second since boot
+uint8_t tenths_millis = 0;	///< Milliseconds counted towards the next tenth
+
+void tick(micros_t board_micros) {
+	if (board_micros < last_micros) {
+		wraps++;
+	}
+	// The interrupt interval is well under a millisecond, so this is one
+	// subtraction rather than a division
+	millis_micros += (uint16_t)(board_micros - last_micros);
+	while (millis_micros >= 1000) {
+		millis_micros -= 1000;
+		millis++;
+		if (++tenths_millis == 100) {
+			tenths_millis = 0;
+			tenths++;
+		}
+	}
+	last_micros = board_micros;
+}
+
+micros64_t getMicros() {
+	micros64_t now;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		now = ((micros64_t)wraps << 32) | last_micros;
+	}
+	return now;
+}
+
+uint32_t getMillis() {
+	uint32_t now;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		now = millis;
+	}
+	return now;
+}
+
+uint32_t getTenths() {
+	uint32_t now;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		now = tenths;
+	}
+	return now;
+}
+
+} // namespace extendedclock
+
+#endif // EXTENDED_CLOCK
@@ -0,0 +1,47 @@
+#ifndef EXTENDED_CLOCK_HH_
+#define EXTENDED_CLOCK_HH_
+
+#include "Types.hh"
+
+/// The extended clock has no time source of its own: it only advances when the
+/// board's clock interrupt calls #tick(), and that interrupt lives with the
+/// board code, outside this tree.  A board defines EXTENDED_CLOCK once its
+/// interrupt makes the call; without it, the clock and the timers built on it
+/// (#LongTimeout, #TimeoutT) would silently never elapse, so using them is an
+/// error.
+#ifndef EXTENDED_CLOCK
+#error "The extended clock needs extendedclock::tick() called from the board clock interrupt; define EXTENDED_CLOCK once the board does"
+#endif
+
+/// The board clock counts microseconds in a #micros_t, which wraps about every
+/// 71.6 minutes.  The extended clock widens it to 64 bits by counting the wraps,
+/// so it can time whole builds.  The board's clock interrupt must call #tick()
+/// each time it advances the board clock, so that no wrap is missed however
+/// long the main loop goes without reading the time.
+namespace extendedclock {
+
+/// Follow the board clock, and advance the millisecond count.  Called from the
+/// board's clock interrupt, from boot, after the board clock has been advanced.
+/// \param[in] board_micros New value of the board clock
+void tick(micros_t board_micros);
+
+/// Get the microseconds since boot, to the resolution of the clock interrupt.
+/// Safe to call from interrupts.
+/// \return Current time, in microseconds
+micros64_t getMicros();
+
+/// Get the milliseconds since boot.  This is the shared tick used by
+/// #MillisTimeout, kept by #tick() so reading it is only a copy; it wraps after
+/// about 49 days.  Safe to call from interrupts.
+/// \return Current time, in milliseconds
+uint32_t getMillis();
+
+/// Get the tenths of a second since boot, the coarse tick used by
+/// #CoarseTimeout.  Like #getMillis(), it is kept by #tick().  Safe to call
+/// from interrupts.
+/// \return Current time, in tenths of a second
+uint32_t getTenths();
+
+}
+
+#endif // EXTENDED_CLOCK_HH_
@@ -0,0 +1,74 @@
+/// Host test of the #extendedclock and #LongTimeout across wraps of the board
+/// clock.  It is not part of the firmware; build and run it on the host with:
+///
+///     g++ -O2 -DHOST_TEST -DEXTENDED_CLOCK -o clocktest ExtendedClockTest.cc ExtendedClock.cc LongTimeout.cc && ./clocktest
+///
+/// The test stands in for the board's clock interrupt, advancing a simulated
+/// 32 bit board clock and calling extendedclock::tick() on every step, through
+/// two and a half wraps.  It checks that the extended time never jumps, that
+/// the millisecond and tenth of a second ticks follow it, and that a timeout
+/// longer than a wrap elapses on time.
+
+#ifdef HOST_TEST
+
+#include <stdio.h>
+#include "ExtendedClock.hh"
+#include "LongTimeout.hh"
+
+/// Clock interrupt interval; larger than the board's, to keep the test short
+static const micros_t INTERVAL_MICROS = 1000 + 24;
+
+int main() {
+	uint32_t errors = 0;
+	micros_t board_micros = 0;
+	micros64_t expected = 0;
+	const micros64_t end = (5ULL << 32) / 2;
+
+	// elapses a quarter of the way through the second wrap
+	const micros64_t long_duration = (5ULL << 32) / 4;
+	LongTimeout timeout;
+	timeout.start(long_duration);
+
+	uint32_t last_millis = 0;
+	while (expected < end) {
+		board_micros += INTERVAL_MICROS;
+		expected += INTERVAL_MICROS;
+		extendedclock::tick(board_micros);
+
+		if (extendedclock::getMicros() != expected) {
+			if (errors++ < 10) {
+				printf("at %llu: getMicros() gave %llu\n", (unsigned long long)expected,
+				       (unsigned long long)extendedclock::getMicros());
+			}
+		}
+		uint32_t millis = extendedclock::getMillis();
+		if (millis != (uint32_t)(expected / 1000) || millis < last_millis) {
+			if (errors++ < 10) {
+				printf("at %llu: getMillis() gave %lu\n", (unsigned long long)expected,
+				       (unsigned long)millis);
+			}
+		}
+		last_millis = millis;
+
+		if (extendedclock::getTenths() != (uint32_t)(expected / 100000)) {
+			if (errors++ < 10) {
+				printf("at %llu: getTenths() gave %lu\n", (unsigned long long)expected,
+				       (unsigned long)extendedclock::getTenths());
+			}
+		}
+
+		if (timeout.hasElapsed() != (expected >= long_duration)) {
+			if (errors++ < 10) {
+				printf("at %llu: timeout %s\n", (unsigned long long)expected,
+				       timeout.hasElapsed() ? "elapsed early" : "has not elapsed");
+			}
+		}
+	}
+
+	printf("%llu microseconds, %llu wraps of the board clock\n",
+	       (unsigned long long)expected, (unsigned long long)(expected >> 32));
+	printf("%s (%lu errors)\n", errors ? "FAIL" : "PASS", (unsigned long)errors);
+	return errors ? 1 : 0;
+}
+
+#endif // HOST_TEST
@@ -21,45 +21,21 @@
 #include "Thermistor.hh"
 #include "Eeprom.hh"
 #include "Motherboard.hh"
+#include "Profiler.hh"
+#include "PowerBudget.hh"
 
 
-/// Offset to compensate for range clipping and bleed-off
-#define HEATER_OFFSET_ADJUSTMENT 0
+/// autotune switches the element on this far below the target, and off this far above it
+const int16_t AUTOTUNE_HYSTERESIS = 1;
 
-/// PID bypass: If the set point is more than this many degrees over the
-///             current temperature, bypass the PID loop altogether.
-#define PID_BYPASS_DELTA 15
+/// number of oscillation cycles autotune averages over
+const uint8_t AUTOTUNE_CYCLES = 5;
 
-/// Number of bad sensor readings we need to get in a row before shutting off the heater
-const uint8_t SENSOR_MAX_BAD_READINGS = 15;
+/// autotune gives up if a single cycle takes more samples than this
+const uint16_t AUTOTUNE_MAX_CYCLE_SAMPLES = 10000;
 
-/// Number of temp readings to be at target value before triggering newTargetReached
-/// with bad seating of thermocouples, we sometimes get innacurate reads
-const uint16_t TARGET_CHECK_COUNT = 5;
-
-/// If we read a temperature higher than this, shut down the heater
-const int16_t HEATER_CUTOFF_TEMPERATURE = 300;
-
-
-/// temperatures below setting by this amount will flag as "not heating up"
-const int16_t HEAT_FAIL_THRESHOLD = 30;
-
-// don't trigger heating up checking for target temperatures less than this
-const int16_t HEAT_FAIL_CHECK_THRESHOLD = 30;
-
-/// if the starting temperature is less than this amount, we will check heating progress
-/// to get to this temperature, the heater has already been checked.
-const int16_t HEAT_CHECKED_THRESHOLD = 50;
-
-/// timeout for heating all the way up
-const uint32_t HEAT_UP_TIME = 300000000;  //five minutes
-
-/// timeout for showing heating progress
-const uint32_t HEAT_PROGRESS_TIME = 90000000; // 90 seconds
-
-
-/// threshold above starting temperature we check for heating progres
-const int16_t HEAT_PROGRESS_THRESHOLD = 10;
+/// autotune gives up if the temperature overshoots the target by more than this
+const int16_t AUTOTUNE_MAX_OVERSHOOT = 20;
 
 Heater::Heater(TemperatureSensor& sensor_in,
                HeatingElement& element_in,
@@ -68,17 +44,30 @@ Heater::Heater(TemperatureSensor& sensor_in,
 		sensor(sensor_in),
 		element(element_in),
 		sample_interval_micros(sample_interval_micros_in),
+		pid_interval_micros(UPDATE_INTERVAL_MICROS),
 		eeprom_base(eeprom_base_in),
 		heat_timing_check(timingCheckOn),
     calibration_eeprom_offset(calibration_offset)
 {
+#ifdef HEATER_POWER_BUDGET
+	power_slot = powerbudget::NO_SLOT;
+#endif
 	reset();
 }
 
+void Heater::setPowerRating(uint16_t watts) {
+#ifdef HEATER_POWER_BUDGET
+	if (power_slot == powerbudget::NO_SLOT) {
+		power_slot = powerbudget::add(watts);
+	}
+#endif
+}
+
 void Heater::reset() {
 	// TODO: Reset sensor, element here?
 
 	current_temperature = 0;
+	current_temperature_sixteenths = 0;
 	startTemp = 0;
 	paused_set_temperature = 0;
 
@@ -93,21 +82,25 @@ void Heater::reset() {
 	newTargetReached = false;
 	is_paused = false;
 	is_disabled = false;
+	autotuning = false;
+#ifdef HEATER_FEED_FORWARD
+	model.reset();
+#endif
 
-	float p = eeprom::getEepromFixed16(eeprom_base+pid_eeprom_offsets::P_TERM,DEFAULT_P);
-	float i = eeprom::getEepromFixed16(eeprom_base+pid_eeprom_offsets::I_TERM,DEFAULT_I);
-	float d = eeprom::getEepromFixed16(eeprom_base+pid_eeprom_offsets::D_TERM,DEFAULT_D);
+	uint16_t p = eeprom::getEepromFixed16Raw(eeprom_base+pid_eeprom_offsets::P_TERM,PID_FIXED16(DEFAULT_P));
+	uint16_t i = eeprom::getEepromFixed16Raw(eeprom_base+pid_eeprom_offsets::I_TERM,PID_FIXED16(DEFAULT_I));
+	uint16_t d = eeprom::getEepromFixed16Raw(eeprom_base+pid_eeprom_offsets::D_TERM,PID_FIXED16(DEFAULT_D));
 
 	pid.reset();
 	if (p == 0 && i == 0 && d == 0) {
-		p = DEFAULT_P; i = DEFAULT_I; d = DEFAULT_D;
+		p = PID_FIXED16(DEFAULT_P); i = PID_FIXED16(DEFAULT_I); d = PID_FIXED16(DEFAULT_D);
 	}
-	pid.setPGain(p);
-	pid.setIGain(i);
-	pid.setDGain(d);
+	pid.setGainsFixed16(p, i, d);
 	pid.setTarget(0);
-	next_pid_timeout.start(UPDATE_INTERVAL_MICROS);
-	//next_sense_timeout.start(sample_interval_micros);
+	next_pid_timeout.schedule(pid_interval_micros);
+	next_sense_timeout.schedule(sample_interval_micros);
+	sample_sum = 0;
+	sample_count = 0;
   calibration_offset = eeprom::getEeprom8(eeprom_offsets::HEATER_CALIBRATION + calibration_eeprom_offset, 0);
 }
 
@@ -124,21 +117,22 @@ void Heater::abort() {
 	newTargetReached = false;
 	is_paused = false;
 	is_disabled = false;
+	autotuning = false;
 
-	float p = eeprom::getEepromFixed16(eeprom_base+pid_eeprom_offsets::P_TERM,DEFAULT_P);
-	float i = eeprom::getEepromFixed16(eeprom_base+pid_eeprom_offsets::I_TERM,DEFAULT_I);
-	float d = eeprom::getEepromFixed16(eeprom_base+pid_eeprom_offsets::D_TERM,DEFAULT_D);
+	uint16_t p = eeprom::getEepromFixed16Raw(eeprom_base+pid_eeprom_offsets::P_TERM,PID_FIXED16(DEFAULT_P));
+	uint16_t i = eeprom::getEepromFixed16Raw(eeprom_base+pid_eeprom_offsets::I_TERM,PID_FIXED16(DEFAULT_I));
+	uint16_t d = eeprom::getEepromFixed16Raw(eeprom_base+pid_eeprom_offsets::D_TERM,PID_FIXED16(DEFAULT_D));
 
 	pid.reset();
 	if (p == 0 && i == 0 && d == 0) {
-		p = DEFAULT_P; i = DEFAULT_I; d = DEFAULT_D;
+		p = PID_FIXED16(DEFAULT_P); i = PID_FIXED16(DEFAULT_I); d = PID_FIXED16(DEFAULT_D);
 	}
-	pid.setPGain(p);
-	pid.setIGain(i);
-	pid.setDGain(d);
+	pid.setGainsFixed16(p, i, d);
 	pid.setTarget(0);
-	next_pid_timeout.start(UPDATE_INTERVAL_MICROS);
-	//next_sense_timeout.start(sample_interval_micros);
+	next_pid_timeout.schedule(pid_interval_micros);
+	next_sense_timeout.schedule(sample_interval_micros);
+	sample_sum = 0;
+	sample_count = 0;
   calibration_offset = eeprom::getEeprom8(eeprom_offsets::HEATER_CALIBRATION + calibration_eeprom_offset, 0);
 }
 
@@ -155,10 +149,11 @@ void Heater::disable(bool on){
   @param temp: temperature in degrees C. Zero degrees indicates
   'disable heaters'
  */
-#define MAX_VALID_TEMP 280
-
 void Heater::set_target_temperature(int16_t target_temp)
 {
+	// a new target cancels any autotune in progress
+	autotuning = false;
+
 	// clip our set temperature if we are over temp.
 	if(target_temp > MAX_VALID_TEMP) {
 		target_temp = MAX_VALID_TEMP;
@@ -202,9 +197,6 @@ void Heater::set_target_temperature(int16_t target_temp)
 	pid.setTarget(target_temp);
 }
 
-// We now define target hysteresis, used as PID over/under range.
-#define TARGET_HYSTERESIS 2
-
 /// Returns true if the current PID temperature is within tolerance
 /// of the expected current temperature.
 bool Heater::has_reached_target_temperature()
@@ -236,6 +228,11 @@ int Heater::get_current_temperature()
 	return current_temperature;
 }
 
+int16_t Heater::get_current_temperature_sixteenths()
+{
+	return current_temperature_sixteenths;
+}
+
 int Heater::getPIDErrorTerm() {
 	return pid.getErrorTerm();
 }
@@ -256,6 +253,13 @@ bool Heater::isCooling(){
 	return (current_temperature > get_set_temperature()) && !has_reached_target_temperature() && !fail_state;
 }
 
+uint16_t Heater::getHeatupEta(){
+	if (!isHeating() || is_paused) {
+		return 0;
+	}
+	return eta.getSeconds(current_temperature, pid.getTarget());
+}
+
 int16_t Heater::getDelta(){
 	
 		uint16_t target = pid.getTarget();
@@ -266,14 +270,13 @@ int16_t Heater::getDelta(){
 
 
 void Heater::manage_temperature() {
+	PROFILE_SLICE(SLICE_HEATERS);
 
-	//if (next_sense_timeout.hasElapsed()) {
-	//	next_sense_timeout.start(sample_interval_micros);
+	if (next_sense_timeout.hasElapsed()) {
 		switch (sensor.update()) {
 		case TemperatureSensor::SS_ADC_BUSY:
 		case TemperatureSensor::SS_ADC_WAITING:
-			// We're waiting for the ADC, so don't update the temperature yet.
-			current_temperature = 2;
+			// We're waiting for the ADC, so try again on the next call.
 			return;
 		case TemperatureSensor::SS_OK:
 			// Result was ok, so reset the fail counter, and continue.
@@ -281,6 +284,7 @@ void Heater::manage_temperature() {
 			break;
 		case TemperatureSensor::SS_BAD_READ:
 			// we got a read for the heater that is outside of the expected range
+			next_sense_timeout.schedule(sample_interval_micros);
 			fail_count++;
 			
 			if (fail_count > SENSOR_MAX_BAD_READINGS) {
@@ -291,6 +295,7 @@ void Heater::manage_temperature() {
 		case TemperatureSensor::SS_ERROR_UNPLUGGED:
 		default:
 			// If we get too many bad readings in a row, shut down the heater.
+			next_sense_timeout.schedule(sample_interval_micros);
 			fail_count++;
 
 			if (fail_count > SENSOR_MAX_BAD_READINGS) {
@@ -299,13 +304,20 @@ void Heater::manage_temperature() {
 			}
 			return;
 		}
-
-		current_temperature = sensor.getTemperature() + calibration_offset;
+		next_sense_timeout.schedule(sample_interval_micros);
+
+		int16_t sample = sensor.getTemperature() + calibration_offset;
+		if (sample_count < 0xff) {
+			// filter with the fraction the sensor gives
+			sample_sum += sensor.getTemperatureSixteenths() +
+				(int16_t)calibration_offset * (1 << TEMPERATURE_FRACTION_BITS);
+			sample_count++;
+		}
 		
 		if (!is_paused){
 			uint8_t old_value_count = value_fail_count;
 			// check that the the heater isn't reading above the maximum allowable temp
-			if (current_temperature > HEATER_CUTOFF_TEMPERATURE) {
+			if (sample > HEATER_CUTOFF_TEMPERATURE) {
 				value_fail_count++;
 
 				if (value_fail_count > SENSOR_MAX_BAD_READINGS) {
@@ -317,7 +329,7 @@ void Heater::manage_temperature() {
 			// check that the heater is heating up after target is set
 			if(!progressChecked){
 				if(heatProgressTimer.hasElapsed()){ 
-					if(current_temperature < (startTemp + HEAT_PROGRESS_THRESHOLD )){
+					if(sample < (startTemp + HEAT_PROGRESS_THRESHOLD )){
 						value_fail_count++;
 
 						if (value_fail_count > SENSOR_MAX_BAD_READINGS) {
@@ -331,7 +343,7 @@ void Heater::manage_temperature() {
 				}
 			}
 			// check that the heater temperature does not drop when still set to high temp
-			if(heatingUpTimer.hasElapsed() && has_reached_target_temperature() && (current_temperature < (pid.getTarget() - HEAT_FAIL_THRESHOLD))){
+			if(heatingUpTimer.hasElapsed() && has_reached_target_temperature() && (sample < (pid.getTarget() - HEAT_FAIL_THRESHOLD))){
 					value_fail_count++;
 
 					if (value_fail_count > SENSOR_MAX_BAD_READINGS) {
@@ -345,37 +357,79 @@ void Heater::manage_temperature() {
 			if(value_fail_count == old_value_count)
 				value_fail_count = 0;
 		}
+	}
 	if (fail_state) {
 		return;
 	}
-		
-	next_pid_timeout.start(UPDATE_INTERVAL_MICROS);
+
+	// Run the controller at its own rate, once there is a new sample for it
+	if (!next_pid_timeout.hasElapsed() || sample_count == 0) {
+		return;
+	}
+	next_pid_timeout.schedule(pid_interval_micros);
+
+	// The controller works from the mean of the samples taken since its last
+	// run, which filters out sensor noise without adding much lag.
+	current_temperature_sixteenths = (sample_sum + sample_count / 2) / sample_count;
+	current_temperature = (current_temperature_sixteenths + (1 << (TEMPERATURE_FRACTION_BITS - 1))) >> TEMPERATURE_FRACTION_BITS;
+	sample_sum = 0;
+	sample_count = 0;
+	eta.update(current_temperature, pid.getTarget());
+
+	if (autotuning) {
+		manage_autotune();
+		return;
+	}
 
 	int delta = pid.getTarget() - current_temperature;
 
-	if( bypassing_PID && (delta < PID_BYPASS_DELTA) ) {
+#ifdef HEATER_FEED_FORWARD
+	model.sample(current_temperature);
+	// leave bypass once the heat still in flight will carry the heater to its
+	// target, but not so early that we would immediately re-enter it
+	int16_t coast = model.getCoastRise();
+	if (coast > PID_BYPASS_DELTA + 5) {
+		coast = PID_BYPASS_DELTA + 5;
+	}
+	// a rise that rounds to nothing tells us no more than the usual margin
+	bool near_target = (coast > 0) ? (delta <= coast) : (delta < PID_BYPASS_DELTA);
+#else
+	bool near_target = (delta < PID_BYPASS_DELTA);
+#endif
+
+	if( bypassing_PID && near_target ) {
 		bypassing_PID = false;
+#ifdef HEATER_FEED_FORWARD
+		model.endHeatup(current_temperature);
+#endif
 
 		pid.reset_state();
 	}
 	else if ( !bypassing_PID && (delta > PID_BYPASS_DELTA + 10) ) {
 		bypassing_PID = true;
+#ifdef HEATER_FEED_FORWARD
+		model.startHeatup(current_temperature);
+#endif
 	}
 
 	if( bypassing_PID ) {
 		set_output(255);
 	}
 	else {
-		int mv = pid.calculate(current_temperature);
+		pid.calculateSixteenths(current_temperature_sixteenths);
+		// keep the fraction of the output, for elements that can use it
+		int32_t mv = pid.getLastOutputFine();
+#ifdef HEATER_FEED_FORWARD
+		// the PID only has to correct for what the model gets wrong
+		mv += (int32_t)model.getSteadyStateOutput(pid.getTarget()) * 256;
+#endif
 		// offset value to compensate for heat bleed-off.
 		// There are probably more elegant ways to do this,
 		// but this works pretty well.
-		mv += HEATER_OFFSET_ADJUSTMENT;
-		// clamp value
-		if (mv < 0) { mv = 0; }
-		if (mv >255) { mv = 255; }
+		mv += (int32_t)HEATER_OFFSET_ADJUSTMENT * 256;
 		if (pid.getTarget() == 0) { mv = 0; }
-		set_output(mv);
+		// clamp value
+		set_output_fine(heatingDutyFromFixed(mv));
 			
 	}
 
@@ -415,13 +469,148 @@ void Heater::Pause(bool on){
 
 void Heater::set_output(uint8_t value)
 {
-	element.setHeatingElement(value);
+	// 255 * 257 is full on
+	set_output_fine((uint16_t)value * 257);
+}
+
+void Heater::set_output_fine(uint16_t value)
+{
+#ifdef HEATER_POWER_BUDGET
+	if (power_slot != powerbudget::NO_SLOT) {
+		uint8_t wanted = value >> 8;
+		uint8_t granted = powerbudget::request(power_slot, wanted, getHeatupEta());
+		if (granted < wanted) {
+			value = (uint16_t)granted * 257;
+		}
+	}
+#endif
+	element.setHeatingElementFine(value);
+
+#ifdef HEATER_TELEMETRY
+	if (telemetry.isRunning()) {
+		TelemetryRecord r;
+		r.stamp = Motherboard::getBoard().getCurrentMicros();
+		r.raw = sensor.getRawValue();
+		r.temperature = current_temperature;
+		r.setpoint = pid.getTarget();
+		pid.getLastTerms(r.p_term, r.i_term, r.d_term);
+		r.output = value >> 8;
+		r.flags = (bypassing_PID ? TELEMETRY_BYPASS : 0) |
+		          (autotuning ? TELEMETRY_AUTOTUNE : 0) |
+		          (fail_state ? TELEMETRY_FAILED : 0) |
+		          (is_paused ? TELEMETRY_PAUSED : 0);
+		telemetry.record(r);
+	}
+#endif
+}
+
+void Heater::startAutotune(int16_t target)
+{
+	set_target_temperature(target);
+	if (has_failed() || is_disabled || pid.getTarget() == 0) {
+		return;
+	}
+
+	autotuning = true;
+	autotune_heating = true;
+	autotune_cycles = 0;
+	autotune_samples = 0;
+	autotune_period_sum = 0;
+	autotune_swing_sum = 0;
+	autotune_max = autotune_min = current_temperature;
+	set_output(255);
+}
+
+// Relay feedback (Astrom-Hagglund): bang-bang control around the target makes
+// the temperature oscillate at the loop's ultimate period.  A cycle runs from
+// one switch-on to the next; the first starts at the first switch-on after
+// the initial heat-up, so the run-up is not measured.
+void Heater::manage_autotune()
+{
+	int16_t target = pid.getTarget();
+
+	if (current_temperature > target + AUTOTUNE_MAX_OVERSHOOT ||
+		autotune_samples >= AUTOTUNE_MAX_CYCLE_SAMPLES) {
+		// not oscillating as expected; give up and leave the gains as they were
+		set_target_temperature(0);
+		set_output(0);
+		return;
+	}
+
+	autotune_samples++;
+	if (current_temperature > autotune_max) {
+		autotune_max = current_temperature;
+	}
+	if (current_temperature < autotune_min) {
+		autotune_min = current_temperature;
+	}
+
+	if (autotune_heating) {
+		if (current_temperature > target + AUTOTUNE_HYSTERESIS) {
+			autotune_heating = false;
+			set_output(0);
+		}
+	} else if (current_temperature < target - AUTOTUNE_HYSTERESIS) {
+		autotune_heating = true;
+		set_output(255);
+
+		if (autotune_cycles > 0) {
+			autotune_period_sum += autotune_samples;
+			autotune_swing_sum += autotune_max - autotune_min;
+		}
+		autotune_cycles++;
+		autotune_samples = 0;
+		autotune_max = autotune_min = current_temperature;
+
+		if (autotune_cycles > AUTOTUNE_CYCLES) {
+			finish_autotune();
+		}
+	}
+}
+
+void Heater::finish_autotune()
+{
+	// The relay swings the output by +/- half of full scale, so the ultimate
+	// gain, in output units per degree, is 4 * 127.5 / (pi * amplitude), with
+	// the amplitude being half the peak to peak swing.
+	float swing = (float)autotune_swing_sum / AUTOTUNE_CYCLES;
+	float period = (float)autotune_period_sum / AUTOTUNE_CYCLES;
+	if (swing < 1) {
+		swing = 1;
+	}
+	float ku = (4.0 * 127.5 * 2.0) / (3.14159 * swing);
+
+	// Classic Ziegler-Nichols gains, in per-sample units.  The PID doubles its
+	// output (OUTPUT_SCALE) and its derivative is summed over DELTA_SAMPLES
+	// deltas, so scale the gains to match.
+	float kp = 0.6 * ku;
+	float p = kp / 2.0;
+	float i = (2.0 * kp / period) / 2.0;
+	float d = (kp * period / 8.0) / 2.0 / DELTA_SAMPLES;
+
+	// keep the gains inside the fixed16 range, below 0xFFFF, which reads back
+	// from the EEPROM as erased
+	const float max_gain = 65279.0 / 256.0;
+	if (p > max_gain) { p = max_gain; }
+	if (i > max_gain) { i = max_gain; }
+	if (d > max_gain) { d = max_gain; }
+
+	eeprom::setEepromFixed16(eeprom_base+pid_eeprom_offsets::P_TERM, p);
+	eeprom::setEepromFixed16(eeprom_base+pid_eeprom_offsets::I_TERM, i);
+	eeprom::setEepromFixed16(eeprom_base+pid_eeprom_offsets::D_TERM, d);
+	pid.setPGain(p);
+	pid.setIGain(i);
+	pid.setDGain(d);
+
+	set_target_temperature(0);
+	set_output(0);
 }
 
 // mark as failed and report to motherboard for user messaging
 void Heater::fail()
 {
 	fail_state = true;
+	autotuning = false;
 	set_output(0);
 	Motherboard::getBoard().heaterFail(fail_mode);
 }
@@ -22,6 +22,9 @@
 #include "HeatingElement.hh"
 #include "Pin.hh"
 #include "PID.hh"
+#include "ThermalModel.hh"
+#include "HeatupEta.hh"
+#include "HeaterTelemetry.hh"
 #include "Types.hh"
 #include "Timeout.hh"
 
@@ -29,6 +32,50 @@
 #define DEFAULT_I 0.325
 #define DEFAULT_D 36.0
 
+/// Offset to compensate for range clipping and bleed-off
+#define HEATER_OFFSET_ADJUSTMENT 0
+
+/// PID bypass: If the set point is more than this many degrees over the
+///             current temperature, bypass the PID loop altogether.
+#define PID_BYPASS_DELTA 15
+
+/// Number of bad sensor readings we need to get in a row before shutting off the heater
+const uint8_t SENSOR_MAX_BAD_READINGS = 15;
+
+/// Number of temp readings to be at target value before triggering newTargetReached
+/// with bad seating of thermocouples, we sometimes get innacurate reads
+const uint16_t TARGET_CHECK_COUNT = 5;
+
+/// If we read a temperature higher than this, shut down the heater
+const int16_t HEATER_CUTOFF_TEMPERATURE = 300;
+
+
+/// temperatures below setting by this amount will flag as "not heating up"
+const int16_t HEAT_FAIL_THRESHOLD = 30;
+
+// don't trigger heating up checking for target temperatures less than this
+const int16_t HEAT_FAIL_CHECK_THRESHOLD = 30;
+
+/// if the starting temperature is less than this amount, we will check heating progress
+/// to get to this temperature, the heater has already been checked.
+const int16_t HEAT_CHECKED_THRESHOLD = 50;
+
+/// timeout for heating all the way up
+const uint32_t HEAT_UP_TIME = 300000000;  //five minutes
+
+/// timeout for showing heating progress
+const uint32_t HEAT_PROGRESS_TIME = 90000000; // 90 seconds
+
+
+/// threshold above starting temperature we check for heating progres
+const int16_t HEAT_PROGRESS_THRESHOLD = 10;
+
+/// Highest target temperature a heater accepts
+#define MAX_VALID_TEMP 280
+
+// We now define target hysteresis, used as PID over/under range.
+#define TARGET_HYSTERESIS 2
+
 enum HeaterFailMode{
 	HEATER_FAIL_NONE = 0,
 	HEATER_FAIL_NOT_PLUGGED_IN = 0x02,
@@ -56,8 +103,13 @@ class Heater
     Timeout next_sense_timeout;         ///< Timeout timer for sensor measurement
     micros_t sample_interval_micros;    ///< Interval that the temperature sensor should
                                         ///< be updated at.
+    micros_t pid_interval_micros;       ///< Interval between PID calculations
+    int32_t sample_sum;                 ///< Sum of the samples since the last PID calculation,
+                                        ///< in sixteenths of a degree
+    uint8_t sample_count;               ///< Number of samples in sample_sum
 
     volatile int16_t current_temperature;       ///< Last known temperature reading
+    volatile int16_t current_temperature_sixteenths; ///< The same, in sixteenths of a degree
     int16_t startTemp;					///< start temperature when new target is set.  used to assess heating up progress 
 	  int16_t paused_set_temperature;		///< we record the set temperature when a heater is "paused"
     bool newTargetReached;				///< flag set when heater reached target and cleared when a new temperature is set
@@ -66,6 +118,15 @@ class Heater
 
     PID pid;                            ///< PID controller instance
     bool bypassing_PID;                 ///< True if the heater is in full on
+#ifdef HEATER_POWER_BUDGET
+    uint8_t power_slot;                 ///< Slot in the #powerbudget, or NO_SLOT
+#endif
+#ifdef HEATER_TELEMETRY
+    HeaterTelemetry telemetry;          ///< Record of recent control ticks
+#endif
+#ifdef HEATER_FEED_FORWARD
+    ThermalModel model;                 ///< Thermal model, identified from full power heat-ups
+#endif
 
     bool fail_state;                    ///< True if the heater has detected a hardware
                                         ///< failure and is shut down.
@@ -76,6 +137,7 @@ class Heater
     uint8_t value_fail_count;			///< a second failure counter for valid temp reads that are out of range (eg too hot)
     HeaterFailMode fail_mode;			///< queryable state to indicate WHY the heater fails
 
+    HeatupEta eta;                      ///< Estimate of the time to reach the target
     Timeout heatingUpTimer;				///< timeout indicating how long heater has been heating
     Timeout heatProgressTimer;			///< timeout to flag if heater is not heating up from start
     bool progressChecked;				///< flag that heating up progress has been checked.
@@ -86,16 +148,31 @@ class Heater
     uint8_t calibration_eeprom_offset; //axis offset in HEATER_CALIBRATE
     int8_t  calibration_offset;   // temperature offset for this heater in degrees C
 
-    /// This is the interval between PID calculations.  It doesn't make sense for
-    /// this to be fast (<1 sec) because of the long system delay between heater
-    /// and sensor.
-    const static micros_t UPDATE_INTERVAL_MICROS = 500L * 1000L;
+    bool autotuning;                    ///< True while a relay autotune is running
+    bool autotune_heating;              ///< Relay state: true if the element is on
+    uint8_t autotune_cycles;            ///< Oscillation cycles measured so far
+    uint16_t autotune_samples;          ///< Samples since the current cycle started
+    uint16_t autotune_period_sum;       ///< Total length of the measured cycles, in samples
+    uint16_t autotune_swing_sum;        ///< Total peak to peak swing of the measured cycles
+    int16_t autotune_max;               ///< Highest temperature in the current cycle
+    int16_t autotune_min;               ///< Lowest temperature in the current cycle
 
     /// Put the heater into a failure state, ensuring that the heating element is
     /// disabled.
     void fail();
 
+    /// Drive the element for one sample of the relay autotune
+    void manage_autotune();
+
+    /// Calculate gains from the autotune measurements, then save and apply them
+    void finish_autotune();
+
   public:
+    /// This is the default interval between PID calculations.  It doesn't make sense for
+    /// this to be fast (<1 sec) because of the long system delay between heater
+    /// and sensor.
+    const static micros_t UPDATE_INTERVAL_MICROS = 500L * 1000L;
+
     /// Instantiate a new heater object.
     /// \param[in] sensor #TemperatureSensor element to use as an input
     /// \param[in] element #HeatingElement to use as an output
@@ -115,6 +192,10 @@ class Heater
     /// \return Current sensor temperature, in degrees Celcius
     int16_t get_current_temperature();
 
+    /// Get the current temperature with the sensor's fraction of a degree
+    /// \return Current temperature, in sixteenths of a degree Celsius
+    int16_t get_current_temperature_sixteenths();
+
     /// Get the setpoint temperature
     /// \return Setpoint temperature, in degrees Celcius
     int16_t get_set_temperature();
@@ -133,16 +214,34 @@ class Heater
     bool has_failed();
 
     /// Run the heater management loop. This must be called periodically,
-    /// at a higher frequency than #sample_interval_micros.
+    /// at a higher frequency than #sample_interval_micros.  The sensor is read
+    /// every #sample_interval_micros, and the PID runs every
+    /// #pid_interval_micros on the mean of the samples taken since its last run.
     void manage_temperature();
 
+    /// Change the interval between PID calculations.  The gains are applied
+    /// per calculation, so changing the interval changes the effective
+    /// integral and derivative gains; retune after changing it.
+    /// \param[in] interval_micros New interval; should be at least the sample interval
+    void setPidInterval(micros_t interval_micros) { pid_interval_micros = interval_micros; }
+
     /// Change the setpoint temperature
     /// \param value New setpoint temperature, in degrees Celcius.
     void set_output(uint8_t value);
 
+    /// Set the element output with the resolution of
+    /// #HeatingElement::setHeatingElementFine()
+    /// \param value Duty cycle, 0 (off) - 0xffff (full on).
+    void set_output_fine(uint16_t value);
+
     /// Reset the heater to a to board-on state
     void reset();
 
+    /// Share the supply with other heaters through the #powerbudget.  Does
+    /// nothing unless the firmware is built with HEATER_POWER_BUDGET.
+    /// \param[in] watts Power the heating element draws at full duty
+    void setPowerRating(uint16_t watts);
+
     /// clear heater target temp and states
     void abort();
     
@@ -173,13 +272,35 @@ class Heater
     
     /// is heater temperature target less than current temperature
     bool isCooling();
+
+    /// Estimate how long the heater will take to reach its target
+    /// \return Seconds until the target is reached, 0 if the heater is not
+    ///         heating up, or HeatupEta::UNKNOWN if it can not tell yet
+    uint16_t getHeatupEta();
     
     /// get heater fail mode
     uint8_t GetFailMode();
     
     void disable(bool on);
 
+    /// Tune the PID gains of this heater by relay feedback.  The element is
+    /// switched fully on below the target and off above it, and the period and
+    /// amplitude of the resulting oscillation give the ultimate gain and period
+    /// of the loop.  The gains calculated from them are saved to EEPROM and used
+    /// from then on.  The heater is turned off when tuning ends.  Setting a new
+    /// target temperature, or aborting the heater, cancels the tune.
+    /// \param[in] target Temperature to oscillate around, in degrees Celsius
+    void startAutotune(int16_t target);
+
+    /// \return True while an autotune is running
+    bool isAutotuning() { return autotuning; }
+
     bool isDisabled(){return is_disabled;}
+
+#ifdef HEATER_TELEMETRY
+    /// \return The telemetry recorder for this heater
+    HeaterTelemetry& getTelemetry() { return telemetry; }
+#endif
 };
 
 #endif // HEATER_H
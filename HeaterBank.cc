@@ -0,0 +1,301 @@
+#include "HeaterBank.hh"
+
+#ifdef HEATER_BANK_SIZE
+
+#include "Eeprom.hh"
+#include "Motherboard.hh"
+#include "Profiler.hh"
+
+HeaterBank::HeaterBank(const micros_t sample_interval_micros_in) :
+		count(0),
+		pending(0),
+		sample_interval_micros(sample_interval_micros_in),
+		pid_interval_micros(Heater::UPDATE_INTERVAL_MICROS)
+{
+	delta_idx = 0;
+	// Shared by every heater, so resetting one must not restart them
+	sense_timeout.start(sample_interval_micros);
+	pid_timeout.start(pid_interval_micros);
+}
+
+uint8_t HeaterBank::add(TemperatureSensor& sensor,
+                        HeatingElement& element,
+                        const uint16_t eeprom_base,
+                        bool heat_timing_check,
+                        uint8_t calibration_offset) {
+	if (count >= HEATER_BANK_SIZE) {
+		return NO_HEATER;
+	}
+	uint8_t heater = count++;
+	sensors[heater] = &sensor;
+	elements[heater] = &element;
+	eeprom_bases[heater] = eeprom_base;
+	calibration_eeprom_offsets[heater] = calibration_offset;
+	flags[heater] = heat_timing_check ? FLAG_TIMING_CHECK : 0;
+	reset(heater);
+	return heater;
+}
+
+void HeaterBank::reset() {
+	for (uint8_t heater = 0; heater < count; heater++) {
+		reset(heater);
+	}
+}
+
+void HeaterBank::reset(uint8_t heater) {
+	flags[heater] &= FLAG_TIMING_CHECK;
+	fail_modes[heater] = HEATER_FAIL_NONE;
+	fail_counts[heater] = 0;
+	cutoff_counts[heater] = 0;
+	value_fail_counts[heater] = 0;
+
+	current_sixteenths[heater] = 0;
+	start_temperatures[heater] = 0;
+	sample_sums[heater] = 0;
+	sample_counts[heater] = 0;
+	heat_up_timers[heater] = Timeout();
+	progress_timers[heater] = Timeout();
+
+	uint16_t base = eeprom_bases[heater];
+	uint16_t p = eeprom::getEepromFixed16Raw(base+pid_eeprom_offsets::P_TERM,PID_FIXED16(DEFAULT_P));
+	uint16_t i = eeprom::getEepromFixed16Raw(base+pid_eeprom_offsets::I_TERM,PID_FIXED16(DEFAULT_I));
+	uint16_t d = eeprom::getEepromFixed16Raw(base+pid_eeprom_offsets::D_TERM,PID_FIXED16(DEFAULT_D));
+	if (p == 0 && i == 0 && d == 0) {
+		p = PID_FIXED16(DEFAULT_P); i = PID_FIXED16(DEFAULT_I); d = PID_FIXED16(DEFAULT_D);
+	}
+	p_gains[heater] = p;
+	i_gains[heater] = i;
+	d_gains[heater] = d;
+	targets[heater] = 0;
+	resetPidState(heater);
+	calibration_offsets[heater] = eeprom::getEeprom8(eeprom_offsets::HEATER_CALIBRATION + calibration_eeprom_offsets[heater], 0);
+
+	elements[heater]->setHeatingElement(0);
+}
+
+void HeaterBank::resetPidState(uint8_t heater) {
+	error_accs[heater] = 0;
+	prev_errors[heater] = 0;
+	delta_summations[heater] = 0;
+	for (uint8_t j = 0; j < DELTA_SAMPLES; j++) {
+		delta_history[j][heater] = 0;
+	}
+}
+
+void HeaterBank::fail(uint8_t heater, HeaterFailMode mode) {
+	flags[heater] |= FLAG_FAILED;
+	fail_modes[heater] = mode;
+	elements[heater]->setHeatingElement(0);
+	Motherboard::getBoard().heaterFail(mode);
+}
+
+void HeaterBank::disable(uint8_t heater, bool on) {
+	if (on) {
+		flags[heater] |= FLAG_DISABLED;
+		targets[heater] = 0;
+		elements[heater]->setHeatingElement(0);
+	} else {
+		flags[heater] &= ~FLAG_DISABLED;
+	}
+}
+
+void HeaterBank::setTargetTemperature(uint8_t heater, int16_t temp) {
+	if (temp > MAX_VALID_TEMP) {
+		temp = MAX_VALID_TEMP;
+	}
+	if (temp < 0) {
+		temp = 0;
+	}
+	if (temp > 0) {
+		Motherboard::getBoard().setBoardStatus(Motherboard::STATUS_HEAT_INACTIVE_SHUTDOWN, false);
+	}
+
+	uint8_t f = flags[heater] & ~FLAG_TARGET_REACHED;
+	if (!(f & (FLAG_FAILED | FLAG_DISABLED)) && (f & FLAG_TIMING_CHECK)) {
+		int16_t current = getCurrentTemperature(heater);
+		start_temperatures[heater] = current;
+		f &= ~FLAG_PROGRESS_CHECKED;
+		value_fail_counts[heater] = 0;
+
+		if (temp > HEAT_FAIL_CHECK_THRESHOLD) {
+			// if the current temp is greater than a (low) threshold, don't check the
+			// heating up time, because we've already done that to get to this temperature
+			if ((temp > current + HEAT_PROGRESS_THRESHOLD) && (current < HEAT_CHECKED_THRESHOLD)) {
+				progress_timers[heater].start(HEAT_PROGRESS_TIME);
+			} else {
+				progress_timers[heater] = Timeout();
+			}
+			heat_up_timers[heater].start(HEAT_UP_TIME);
+		} else {
+			heat_up_timers[heater] = Timeout();
+			progress_timers[heater] = Timeout();
+		}
+	}
+	flags[heater] = f;
+
+	if (targets[heater] != temp) {
+		resetPidState(heater);
+		targets[heater] = temp;
+	}
+}
+
+bool HeaterBank::hasReachedTargetTemperature(uint8_t heater) {
+	// flag temperature reached so that PID variations don't trigger this
+	// a second time
+	if (!(flags[heater] & FLAG_TARGET_REACHED)) {
+		int16_t current = getCurrentTemperature(heater);
+		if ((current >= targets[heater] - TARGET_HYSTERESIS) &&
+			(current <= targets[heater] + TARGET_HYSTERESIS)) {
+			flags[heater] |= FLAG_TARGET_REACHED;
+		}
+	}
+	return flags[heater] & FLAG_TARGET_REACHED;
+}
+
+void HeaterBank::manage() {
+	PROFILE_SLICE(SLICE_HEATERS);
+
+	if (sense_timeout.hasElapsed()) {
+		sense_timeout.schedule(sample_interval_micros);
+		pending = 0;
+		for (uint8_t heater = 0; heater < count; heater++) {
+			if (!(flags[heater] & (FLAG_FAILED | FLAG_DISABLED))) {
+				pending |= (1 << heater);
+			}
+		}
+	}
+	if (pending) {
+		sense();
+	}
+
+	if (pid_timeout.hasElapsed()) {
+		pid_timeout.schedule(pid_interval_micros);
+		control();
+	}
+}
+
+void HeaterBank::sense() {
+	for (uint8_t heater = 0; heater < count; heater++) {
+		uint8_t bit = (1 << heater);
+		if (!(pending & bit)) {
+			continue;
+		}
+		TemperatureSensor::SensorState state = sensors[heater]->update();
+		if (state == TemperatureSensor::SS_ADC_BUSY || state == TemperatureSensor::SS_ADC_WAITING) {
+			// try again on the next call
+			continue;
+		}
+		pending &= ~bit;
+
+		if (state != TemperatureSensor::SS_OK) {
+			// If we get too many bad readings in a row, shut down the heater.
+			if (++fail_counts[heater] > SENSOR_MAX_BAD_READINGS) {
+				fail(heater, (state == TemperatureSensor::SS_BAD_READ) ?
+				     HEATER_FAIL_TEMP_OUT_OF_RANGE : HEATER_FAIL_NOT_PLUGGED_IN);
+			}
+			continue;
+		}
+		fail_counts[heater] = 0;
+
+		int16_t sample = sensors[heater]->getTemperature() + calibration_offsets[heater];
+		if (sample_counts[heater] < 0xff) {
+			sample_sums[heater] += sensors[heater]->getTemperatureSixteenths() +
+				(int16_t)calibration_offsets[heater] * (1 << TEMPERATURE_FRACTION_BITS);
+			sample_counts[heater]++;
+		}
+
+		// check that the the heater isn't reading above the maximum allowable temp
+		if (sample > HEATER_CUTOFF_TEMPERATURE) {
+			if (++cutoff_counts[heater] > SENSOR_MAX_BAD_READINGS) {
+				fail(heater, HEATER_FAIL_SOFTWARE_CUTOFF);
+				continue;
+			}
+		} else {
+			cutoff_counts[heater] = 0;
+		}
+
+		// The heat-up checks are made on every sample, as Heater makes them
+		uint8_t old_value_count = value_fail_counts[heater];
+		// check that the heater is heating up after target is set
+		if (!(flags[heater] & FLAG_PROGRESS_CHECKED) && progress_timers[heater].hasElapsed()) {
+			if (sample < start_temperatures[heater] + HEAT_PROGRESS_THRESHOLD) {
+				if (valueFail(heater, HEATER_FAIL_NOT_HEATING)) {
+					continue;
+				}
+			} else {
+				flags[heater] |= FLAG_PROGRESS_CHECKED;
+			}
+		}
+		// check that the heater temperature does not drop when still set to high temp
+		if (heat_up_timers[heater].hasElapsed() && hasReachedTargetTemperature(heater) &&
+			(sample < targets[heater] - HEAT_FAIL_THRESHOLD)) {
+			if (valueFail(heater, HEATER_FAIL_DROPPING_TEMP)) {
+				continue;
+			}
+		}
+		// if no bad heat reads have occured, clear the fail count
+		if (value_fail_counts[heater] == old_value_count) {
+			value_fail_counts[heater] = 0;
+		}
+	}
+}
+
+bool HeaterBank::valueFail(uint8_t heater, HeaterFailMode mode) {
+	if (++value_fail_counts[heater] > SENSOR_MAX_BAD_READINGS) {
+		fail(heater, mode);
+		return true;
+	}
+	return false;
+}
+
+void HeaterBank::control() {
+	for (uint8_t heater = 0; heater < count; heater++) {
+		uint8_t f = flags[heater];
+		if (f & (FLAG_FAILED | FLAG_DISABLED)) {
+			resetPidState(heater);
+			continue;
+		}
+
+		// The PID works from the mean of the samples taken since its last
+		// tick.  With none, as while the ADC is busy, leave the output as it
+		// is rather than run on stale data.  The delta history slot for this
+		// tick is still reused, so retire its old delta from the sum.
+		uint8_t n = sample_counts[heater];
+		if (n == 0) {
+			delta_summations[heater] -= delta_history[delta_idx][heater];
+			delta_history[delta_idx][heater] = 0;
+			continue;
+		}
+		current_sixteenths[heater] = (sample_sums[heater] + n / 2) / n;
+		sample_sums[heater] = 0;
+		sample_counts[heater] = 0;
+		int16_t current = getCurrentTemperature(heater);
+		int16_t target = targets[heater];
+
+		int delta = target - current;
+		if ((f & FLAG_BYPASS) && (delta < PID_BYPASS_DELTA)) {
+			f &= ~FLAG_BYPASS;
+			resetPidState(heater);
+		} else if (!(f & FLAG_BYPASS) && (delta > PID_BYPASS_DELTA + 10)) {
+			f |= FLAG_BYPASS;
+		}
+		flags[heater] = (flags[heater] & ~FLAG_BYPASS) | (f & FLAG_BYPASS);
+
+		if (f & FLAG_BYPASS) {
+			// The history is cleared when the PID takes over again
+			elements[heater]->setHeatingElement(255);
+			continue;
+		}
+
+		int e = (target << TEMPERATURE_FRACTION_BITS) - current_sixteenths[heater];
+		int32_t sum = PID::calculateSum(e, p_gains[heater], i_gains[heater], d_gains[heater],
+		                                error_accs[heater], prev_errors[heater], delta_summations[heater],
+		                                delta_history[delta_idx][heater]);
+		int32_t mv = PID::scaleOutputFine(sum) + (int32_t)HEATER_OFFSET_ADJUSTMENT * 256;
+		if (target == 0) { mv = 0; }
+		elements[heater]->setHeatingElementFine(heatingDutyFromFixed(mv));
+	}
+	delta_idx = (delta_idx + 1) % DELTA_SAMPLES;
+}
+
+#endif // HEATER_BANK_SIZE
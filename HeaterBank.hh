@@ -0,0 +1,196 @@
+#ifndef HEATER_BANK_HH_
+#define HEATER_BANK_HH_
+
+#include <stdint.h>
+#include "Heater.hh"
+#include "TemperatureSensor.hh"
+#include "HeatingElement.hh"
+#include "PID.hh"
+#include "Types.hh"
+#include "Timeout.hh"
+
+#ifndef SIMULATOR
+#include "Configuration.hh"
+#endif
+
+#ifdef HEATER_BANK_SIZE
+
+#if HEATER_BANK_SIZE > 8
+#error "HEATER_BANK_SIZE is limited to 8 heaters"
+#endif
+
+/// A heater bank controls a fixed number of heaters together, for machines
+/// with more toolheads or a heated chamber.  Where each #Heater carries its
+/// own timers and #PID object, the bank keeps every piece of per-heater state
+/// in an array indexed by heater, shares one sample timer and one PID timer
+/// between all of them, and manages every heater in a single pass:
+///
+/// - each sample interval, every heater's sensor is read, retrying any whose
+///   ADC is busy on the following calls, and each sample is checked against
+///   the cutoff, heat-up and dropping temperature limits;
+/// - each PID interval, the samples are averaged and the PID output is
+///   written to every element.
+///
+/// The control law and safety limits are the ones #Heater uses; the PID
+/// arithmetic is PID::calculateSum(), run on the bank's arrays.  Pausing,
+/// autotune, the thermal model, telemetry and the power budget are only
+/// available on #Heater.
+///
+/// The bank is only compiled in when HEATER_BANK_SIZE is defined, as the
+/// number of heaters it holds.
+/// \ingroup SoftwareLibraries
+class HeaterBank {
+public:
+	/// Returned by #add() when the bank is full
+	const static uint8_t NO_HEATER = 0xff;
+
+private:
+	/// Per-heater state flags
+	enum {
+		FLAG_BYPASS = 0x01,             ///< Element is full on, bypassing the PID
+		FLAG_FAILED = 0x02,             ///< Heater has failed and is shut down
+		FLAG_DISABLED = 0x04,           ///< Heater is not present
+		FLAG_TIMING_CHECK = 0x08,       ///< Heat-up progress is checked
+		FLAG_PROGRESS_CHECKED = 0x10,   ///< Heat-up progress has been seen
+		FLAG_TARGET_REACHED = 0x20,     ///< Target reached since it was set
+	};
+
+	TemperatureSensor* sensors[HEATER_BANK_SIZE];   ///< Input of each heater
+	HeatingElement* elements[HEATER_BANK_SIZE];     ///< Output of each heater
+	uint16_t eeprom_bases[HEATER_BANK_SIZE];        ///< Base of each heater's PID settings
+	uint8_t calibration_eeprom_offsets[HEATER_BANK_SIZE]; ///< Offset in HEATER_CALIBRATE
+	int8_t calibration_offsets[HEATER_BANK_SIZE];   ///< Temperature offset, in degrees C
+
+	uint8_t flags[HEATER_BANK_SIZE];                ///< FLAG_* bits of each heater
+	uint8_t fail_modes[HEATER_BANK_SIZE];           ///< #HeaterFailMode of each heater
+	uint8_t fail_counts[HEATER_BANK_SIZE];          ///< Consecutive failed sensor reads
+	uint8_t cutoff_counts[HEATER_BANK_SIZE];        ///< Consecutive reads over the cutoff
+	uint8_t value_fail_counts[HEATER_BANK_SIZE];    ///< Consecutive failed heat-up checks
+
+	int16_t current_sixteenths[HEATER_BANK_SIZE];   ///< Mean of the last PID tick's samples,
+	                                                ///< in sixteenths of a degree
+	int16_t start_temperatures[HEATER_BANK_SIZE];   ///< Temperature when the target was set
+	int32_t sample_sums[HEATER_BANK_SIZE];          ///< Sum of the samples this PID tick, in sixteenths
+	uint8_t sample_counts[HEATER_BANK_SIZE];        ///< Number of samples in sample_sums
+
+	Timeout heat_up_timers[HEATER_BANK_SIZE];       ///< Time allowed to reach the target
+	Timeout progress_timers[HEATER_BANK_SIZE];      ///< Time allowed to show some progress
+
+	uint16_t p_gains[HEATER_BANK_SIZE];             ///< Proportional gains, fixed16
+	uint16_t i_gains[HEATER_BANK_SIZE];             ///< Integral gains, fixed16
+	uint16_t d_gains[HEATER_BANK_SIZE];             ///< Derivative gains, fixed16
+	int16_t targets[HEATER_BANK_SIZE];              ///< Set points
+	int error_accs[HEATER_BANK_SIZE];               ///< Accumulated errors, in sixteenths
+	int prev_errors[HEATER_BANK_SIZE];              ///< Errors at the last PID tick, in sixteenths
+	int delta_summations[HEATER_BANK_SIZE];         ///< Sums of the delta histories, in sixteenths
+	/// Error deltas of the last #DELTA_SAMPLES PID ticks.  Every heater's PID
+	/// steps together, so they share one history index.
+	int16_t delta_history[DELTA_SAMPLES][HEATER_BANK_SIZE];
+	uint8_t delta_idx;                              ///< Current index in delta_history
+
+	uint8_t count;                  ///< Number of heaters added
+	uint8_t pending;                ///< Heaters still to be sampled this interval, one bit each
+	Timeout sense_timeout;          ///< Timer for the next sample of every heater
+	Timeout pid_timeout;            ///< Timer for the next PID tick of every heater
+	micros_t sample_interval_micros;    ///< Interval between samples
+	micros_t pid_interval_micros;       ///< Interval between PID ticks
+
+	/// Shut a heater down after a hardware failure
+	void fail(uint8_t heater, HeaterFailMode mode);
+
+	/// Clear a heater's PID loop variables
+	void resetPidState(uint8_t heater);
+
+	/// Read and check every heater still waiting for this interval's sample
+	void sense();
+
+	/// Run the PID of every heater, and set their outputs
+	void control();
+
+	/// Record a failed heat-up check
+	/// \return True if the heater failed because of it
+	bool valueFail(uint8_t heater, HeaterFailMode mode);
+
+public:
+	/// Create an empty bank
+	/// \param[in] sample_interval_micros Interval to sample the sensors at,
+	///                                   in microseconds.
+	HeaterBank(const micros_t sample_interval_micros);
+
+	/// Add a heater to the bank.  Its settings are loaded from EEPROM.
+	/// \param[in] sensor #TemperatureSensor to use as an input
+	/// \param[in] element #HeatingElement to use as an output
+	/// \param[in] eeprom_base EEPROM address where the PID settings are stored.
+	/// \param[in] heat_timing_check whether or not we should monitor heat-up time
+	/// \param[in] calibration_offset axis offset in HEATER_CALIBRATE field of eeprom
+	/// \return Index of the heater, or #NO_HEATER if the bank is full
+	uint8_t add(TemperatureSensor& sensor,
+	            HeatingElement& element,
+	            const uint16_t eeprom_base,
+	            bool heat_timing_check,
+	            uint8_t calibration_offset);
+
+	/// \return Number of heaters in the bank
+	uint8_t getCount() const { return count; }
+
+	/// Reset every heater to a board-on state, with its element off
+	void reset();
+
+	/// Reset one heater to a board-on state, with its element off
+	/// \param[in] heater Heater index
+	void reset(uint8_t heater);
+
+	/// Read the sensors and run the PID loops that are due.  This must be
+	/// called periodically, at a higher frequency than the sample interval.
+	void manage();
+
+	/// Change the interval between PID ticks.  The gains are applied per tick,
+	/// so this changes the effective integral and derivative gains.
+	/// \param[in] interval_micros New interval; should be at least the sample interval
+	void setPidInterval(micros_t interval_micros) { pid_interval_micros = interval_micros; }
+
+	/// Set a heater's target temperature
+	/// \param[in] heater Heater index
+	/// \param[in] temp New target temperature, in degrees Celsius; 0 for off
+	void setTargetTemperature(uint8_t heater, int16_t temp);
+
+	/// \param[in] heater Heater index
+	/// \return Target temperature, in degrees Celsius
+	int16_t getSetTemperature(uint8_t heater) const { return targets[heater]; }
+
+	/// \param[in] heater Heater index
+	/// \return Temperature the PID last ran on, rounded to whole degrees Celsius
+	int16_t getCurrentTemperature(uint8_t heater) const {
+		return (current_sixteenths[heater] + (1 << (TEMPERATURE_FRACTION_BITS - 1))) >> TEMPERATURE_FRACTION_BITS;
+	}
+
+	/// \param[in] heater Heater index
+	/// \return Temperature the PID last ran on, in sixteenths of a degree Celsius
+	int16_t getCurrentTemperatureSixteenths(uint8_t heater) const { return current_sixteenths[heater]; }
+
+	/// Check if a heater has been within #TARGET_HYSTERESIS degrees of its
+	/// target since the target was set
+	/// \param[in] heater Heater index
+	bool hasReachedTargetTemperature(uint8_t heater);
+
+	/// \param[in] heater Heater index
+	/// \return True if the heater has failed
+	bool hasFailed(uint8_t heater) const { return flags[heater] & FLAG_FAILED; }
+
+	/// \param[in] heater Heater index
+	/// \return #HeaterFailMode of the heater
+	uint8_t getFailMode(uint8_t heater) const { return fail_modes[heater]; }
+
+	/// Mark a heater as present or not; an absent heater is never read or driven
+	/// \param[in] heater Heater index
+	/// \param[in] on True to disable the heater
+	void disable(uint8_t heater, bool on);
+
+	/// \param[in] heater Heater index
+	/// \return True if the heater is disabled
+	bool isDisabled(uint8_t heater) const { return flags[heater] & FLAG_DISABLED; }
+};
+
+#endif // HEATER_BANK_SIZE
+
+#endif // HEATER_BANK_HH_
@@ -0,0 +1,122 @@
+#include "HeaterTelemetry.hh"
+
+#ifdef HEATER_TELEMETRY
+
+#ifndef IS_EXTRUDER_BOARD
+	#include <avr/wdt.h>
+	#include "SDCard.hh"
+#endif
+
+void HeaterTelemetry::start() {
+	records.reset();
+	dropped = 0;
+	running = true;
+}
+
+#ifndef IS_EXTRUDER_BOARD
+static void writeRecord(const TelemetryRecord& r);
+#endif
+
+void HeaterTelemetry::stop() {
+	running = false;
+#ifndef IS_EXTRUDER_BOARD
+	if (logging) {
+		logging = false;
+		sdcard::finishCapture();
+	}
+#endif
+}
+
+void HeaterTelemetry::record(const TelemetryRecord& record) {
+	if (!running) {
+		return;
+	}
+#ifndef IS_EXTRUDER_BOARD
+	if (logging) {
+		writeRecord(record);
+	}
+#endif
+	if (records.getRemainingCapacity() == 0) {
+		records.pop();
+		if (dropped != 0xffff) {
+			dropped++;
+		}
+	}
+	records.push(record);
+}
+
+uint8_t HeaterTelemetry::read(OutPacket& out, uint8_t max_bytes) {
+	uint8_t count = 0;
+	while (count + TELEMETRY_RECORD_SIZE <= max_bytes && !records.isEmpty()) {
+		TelemetryRecord r = records.pop();
+		out.append32(r.stamp);
+		out.append16(r.raw);
+		out.append16(r.temperature);
+		out.append16(r.setpoint);
+		out.append16(r.p_term);
+		out.append16(r.i_term);
+		out.append16(r.d_term);
+		out.append8(r.output);
+		out.append8(r.flags);
+		count += TELEMETRY_RECORD_SIZE;
+	}
+	return count;
+}
+
+#ifndef IS_EXTRUDER_BOARD
+
+/// Write a value to the capture file, least significant byte first
+static void writeBytes(uint32_t value, uint8_t size) {
+	for (uint8_t i = 0; i < size; i++) {
+		sdcard::writeByte(value & 0xff);
+		value >>= 8;
+	}
+}
+
+/// Write a record to the capture file, in the layout the host reads
+static void writeRecord(const TelemetryRecord& r) {
+	writeBytes(r.stamp, 4);
+	writeBytes((uint16_t)r.raw, 2);
+	writeBytes((uint16_t)r.temperature, 2);
+	writeBytes((uint16_t)r.setpoint, 2);
+	writeBytes((uint16_t)r.p_term, 2);
+	writeBytes((uint16_t)r.i_term, 2);
+	writeBytes((uint16_t)r.d_term, 2);
+	writeBytes(r.output, 1);
+	writeBytes(r.flags, 1);
+}
+
+bool HeaterTelemetry::startSDLog(const char *filename) {
+	char fname[16];
+
+	stop();
+
+	strlcpy(fname, filename, sizeof(fname));
+	if ( sdcard::startCapture(fname) != sdcard::SD_SUCCESS )	return false;
+
+	start();
+	logging = true;
+	return true;
+}
+
+bool HeaterTelemetry::saveToSDFile(const prog_char *filename) {
+	char fname[16];
+
+	stop();
+
+	strlcpy_P(fname, filename, sizeof(fname));
+	if ( sdcard::startCapture(fname) != sdcard::SD_SUCCESS )	return false;
+
+	while (!records.isEmpty()) {
+		writeRecord(records.pop());
+		wdt_reset();
+	}
+
+	sdcard::finishCapture();
+
+	return true;
+}
+
+#endif
+
+#endif // HEATER_TELEMETRY
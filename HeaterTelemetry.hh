@@ -0,0 +1,109 @@
+#ifndef HEATER_TELEMETRY_HH_
+#define HEATER_TELEMETRY_HH_
+
+#include <stdint.h>
+#include "CircularBuffer.hh"
+#include "Packet.hh"
+#include "Types.hh"
+
+#ifndef SIMULATOR
+#include <avr/pgmspace.h>
+#include "Configuration.hh"
+#endif
+
+/// Number of records kept by each heater's telemetry ring.  At one record per
+/// control tick this only covers a few seconds, enough to let the host read
+/// at its own pace; a whole heat-up is captured by logging to SD.
+#ifndef HEATER_TELEMETRY_SIZE
+#define HEATER_TELEMETRY_SIZE 8
+#endif
+
+/// Flags stored in each telemetry record
+enum TelemetryFlags {
+	TELEMETRY_BYPASS = 1 << 0,      ///< Heater was in full power bypass
+	TELEMETRY_AUTOTUNE = 1 << 1,    ///< Heater was running an autotune
+	TELEMETRY_FAILED = 1 << 2,      ///< Heater had failed
+	TELEMETRY_PAUSED = 1 << 3,      ///< Heater was paused
+};
+
+/// One sample of heater state, recorded every time the heater sets its
+/// output.  Records are sent to the host, and written to SD, as these fields
+/// in order, little endian, TELEMETRY_RECORD_SIZE bytes in all.
+struct TelemetryRecord {
+	uint32_t stamp;         ///< Time of the sample, from getCurrentMicros()
+	int16_t raw;            ///< Sensor reading before conversion and calibration
+	int16_t temperature;    ///< Calibrated temperature, in degrees Celsius
+	int16_t setpoint;       ///< Target temperature, in degrees Celsius
+	int16_t p_term;         ///< Proportional contribution to the PID output
+	int16_t i_term;         ///< Integral contribution to the PID output
+	int16_t d_term;         ///< Derivative contribution to the PID output
+	uint8_t output;         ///< Duty cycle applied to the element
+	uint8_t flags;          ///< Combination of #TelemetryFlags
+};
+
+#define TELEMETRY_RECORD_SIZE 18
+
+/// A flight recorder for one heater.  While it is running it keeps the most
+/// recent records, discarding the oldest when it is full; the host streams
+/// them out with HOST_CMD_HEATER_TELEMETRY, or they can be saved to SD.
+/// Unlike the #packetlog, reading does not stop the capture, so a host that
+/// reads fast enough sees every control tick.  For runs longer than the ring,
+/// such as a whole heat-up, the recorder can also write every record to a
+/// file on the SD card as it is made.
+///
+/// Heaters only keep telemetry when the firmware is built with
+/// HEATER_TELEMETRY.
+/// \ingroup SoftwareLibraries
+class HeaterTelemetry {
+private:
+	StaticCircularBuffer<TelemetryRecord, HEATER_TELEMETRY_SIZE> records;
+	bool running;           ///< True while records are being kept
+	bool logging;           ///< True while records are also written to SD
+	uint16_t dropped;       ///< Records discarded to make room for newer ones
+
+public:
+	HeaterTelemetry() : running(false), logging(false), dropped(0) {}
+
+	/// Clear the ring and begin recording
+	void start();
+
+	/// Stop recording, closing the SD log if there is one; the records in
+	/// the ring are kept
+	void stop();
+
+	/// \return True if records are being kept
+	bool isRunning() const { return running; }
+
+	/// Add a record, if running
+	/// \param[in] record Sample to keep
+	void record(const TelemetryRecord& record);
+
+	/// Move as many whole records as fit into max_bytes from the ring to a
+	/// response packet
+	/// \param[out] out Packet to append the records to
+	/// \param[in] max_bytes Space left in the packet
+	/// \return Number of bytes appended
+	uint8_t read(OutPacket& out, uint8_t max_bytes);
+
+	/// \return Number of records discarded since the last start
+	uint16_t getDroppedCount() const { return dropped; }
+
+#ifndef IS_EXTRUDER_BOARD
+	/// Clear the ring and begin recording, writing each record to a file on
+	/// the SD card as well, until #stop() is called.  The SD card holds one
+	/// capture file at a time, so only one heater can log at once.
+	/// \param[in] filename Name of the file to write, as sent by the host
+	/// \return True if the file was opened and recording started
+	bool startSDLog(const char *filename);
+
+	/// \return True if records are being written to the SD card
+	bool isLogging() const { return logging; }
+
+	/// Stop recording and write the ring to a file on the SD card, emptying it.
+	/// \param[in] filename Name of the file to write, in program memory
+	/// \return True if the file was written
+	bool saveToSDFile(const prog_char *filename);
+#endif
+};
+
+#endif // HEATER_TELEMETRY_HH_
@@ -31,6 +31,26 @@ public:
         ///                  may not support this, and will interpret this as
         ///                  a binary on/off command instead.
         virtual void setHeatingElement(uint8_t value) =0;
+
+        /// Set the output of the heating element with more than 8 bits of
+        /// resolution.  Elements that can not do better use the top byte.
+        /// \param[in] value Duty cycle, 0 (off) - 0xffff (full on).
+        virtual void setHeatingElementFine(uint16_t value) { setHeatingElement(value >> 8); }
 };
 
+/// Convert a duty cycle of 0 - 255 with 8 fractional bits, as the heater
+/// controllers calculate it, to the scale of #HeatingElement::setHeatingElementFine().
+/// \param[in] duty Duty cycle; clamped to 0 - 255
+/// \return Duty cycle, 0 - 0xffff
+inline uint16_t heatingDutyFromFixed(int32_t duty) {
+        if (duty <= 0) {
+                return 0;
+        }
+        if (duty >= 255L * 256) {
+                return 0xffff;
+        }
+        // scale by 257/256, so that 255 is full on as it is for 8 bit duties
+        return duty + (duty >> 8);
+}
+
 #endif // HEATINGELEMENT_HH_
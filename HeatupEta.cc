@@ -0,0 +1,61 @@
+#include "HeatupEta.hh"
+
+/// Seconds between rate samples
+#define ETA_SAMPLE_SECONDS 4
+
+void HeatupEta::reset() {
+	sample_timer = Timeout();
+	slope = 0;
+	peak_slope = 0;
+}
+
+void HeatupEta::update(int16_t temp, int16_t target) {
+	if (target == 0 || temp >= target) {
+		reset();
+		return;
+	}
+	if (!sample_timer.isActive() && !sample_timer.hasElapsed()) {
+		// first reading of this heat-up
+		last_temp = temp;
+		sample_timer.start(ETA_SAMPLE_SECONDS * 1000000L);
+		return;
+	}
+	if (!sample_timer.hasElapsed()) {
+		return;
+	}
+	sample_timer.clear();
+	sample_timer.start(ETA_SAMPLE_SECONDS * 1000000L);
+
+	int16_t rise = temp - last_temp;
+	uint16_t sample = (rise > 0) ? (uint16_t)rise * 16 / ETA_SAMPLE_SECONDS : 0;
+	last_temp = temp;
+
+	slope = (slope == 0) ? sample : (uint16_t)(((uint32_t)slope + sample) / 2);
+	if (slope > peak_slope) {
+		peak_slope = slope;
+		peak_temp = temp;
+	}
+}
+
+uint16_t HeatupEta::getSeconds(int16_t temp, int16_t target) const {
+	if (temp >= target) {
+		return 0;
+	}
+	if (slope == 0) {
+		return UNKNOWN;
+	}
+	int32_t remaining = target - temp;
+
+	// project the rate at the target from how it has fallen since its peak
+	int32_t final_slope = slope;
+	if (peak_slope > slope && temp > peak_temp) {
+		final_slope -= (int32_t)(peak_slope - slope) * remaining / (temp - peak_temp);
+	}
+	// a rate falling to zero would never arrive; the PID pushes harder than that
+	if (final_slope < slope / 4) {
+		final_slope = slope / 4;
+	}
+
+	uint32_t seconds = (uint32_t)(remaining * 2 * 16) / (uint32_t)(slope + final_slope);
+	return (seconds >= UNKNOWN) ? UNKNOWN - 1 : (uint16_t)seconds;
+}
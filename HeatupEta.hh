@@ -0,0 +1,49 @@
+#ifndef HEATUP_ETA_HH_
+#define HEATUP_ETA_HH_
+
+#include <stdint.h>
+#include "Timeout.hh"
+
+/// Estimates how long a heater will take to reach its target.  The rate of
+/// rise is measured every few seconds and smoothed.  Heating slows as the
+/// heater gets hotter and loses more heat, so the estimate also follows the
+/// approach curve: the rate is taken to fall linearly with temperature, at the
+/// rate it has fallen since its peak during this heat-up, and the time is the
+/// remaining rise divided by the average of the current and projected final
+/// rates.
+/// \ingroup SoftwareLibraries
+class HeatupEta {
+private:
+	Timeout sample_timer;           ///< Time until the next rate sample
+	int16_t last_temp;              ///< Temperature at the last rate sample
+	uint16_t slope;                 ///< Smoothed rate of rise, 1/16 degree per second; 0 if unknown
+	int16_t peak_temp;              ///< Temperature at which the highest rate was seen
+	uint16_t peak_slope;            ///< Highest smoothed rate seen during this heat-up
+
+public:
+	/// Estimate returned when the heater is not rising, or has not been
+	/// measured for long enough
+	const static uint16_t UNKNOWN = 0xffff;
+
+	HeatupEta() { reset(); }
+
+	/// Forget the current heat-up
+	void reset();
+
+	/// Add a temperature reading
+	/// \param[in] temp Current temperature
+	/// \param[in] target Target temperature, or 0 if the heater is off
+	void update(int16_t temp, int16_t target);
+
+	/// \param[in] temp Current temperature
+	/// \param[in] target Target temperature
+	/// \return Estimated seconds until the target is reached, 0 if it has
+	/// been, or #UNKNOWN
+	uint16_t getSeconds(int16_t temp, int16_t target) const;
+
+	/// Combine the estimates of two heaters into the time until both are ready
+	/// \return The later of the two estimates; unknown if either is
+	static uint16_t combine(uint16_t a, uint16_t b) { return (a > b) ? a : b; }
+};
+
+#endif // HEATUP_ETA_HH_
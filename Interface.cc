@@ -2,6 +2,7 @@
 #include "Interface.hh"
 #include "InterfaceBoard.hh"
 #include "Configuration.hh"
+#include "Task.hh"
 
 
 // TODO: Make this a proper module.
@@ -13,6 +14,13 @@ namespace interface {
 LiquidCrystalSerial* lcd;
 InterfaceBoard* board;
 
+/// Low priority: heater control and packet service come first
+const static uint8_t TASK_PRIORITY = 1;
+/// Time a single redraw step should take
+const static micros_t TASK_BUDGET = 2000;
+/// The interface update, registered with the #tasks scheduler
+Task task;
+
 bool isConnected() {
 	// Avoid repeatedly creating temp objects
 	const Pin InterfaceDetect = INTERFACE_DETECT;
@@ -43,6 +51,13 @@ void setBuildPercentage(uint8_t percent){
 
 void init(InterfaceBoard* board_in) {
   board = board_in;
+
+  // runTask() sets the period from the screen once one is showing
+  task.run = runTask;
+  task.period = 50L * 1000L;
+  task.budget = TASK_BUDGET;
+  task.priority = TASK_PRIORITY;
+  tasks::add(task);
 }
 
 void pushScreen(Screen* newScreen) {
@@ -68,6 +83,15 @@ void doUpdate() {
   board->doUpdate();
 }
 
+bool runTask() {
+  bool finished = board->runTask();
+  if (finished) {
+    // follow the update rate of whichever screen is showing now
+    task.period = board->getUpdateRate();
+  }
+  return finished;
+}
+
 }
 
 #endif
@@ -29,7 +29,9 @@
 namespace interface {
 
 /// Set the current interface board and lcd. This *must* be called before using
-/// any of the functions in this interface.
+/// any of the functions in this interface.  It also registers #runTask() with
+/// the #tasks scheduler, so a main loop that calls tasks::runSlice() must not
+/// call #doUpdate() as well.
 void init(InterfaceBoard* board_in);
 
 /// Returns true if the interface board is connected
@@ -55,6 +57,11 @@ void doInterrupt();
 /// time to run.
 void doUpdate();
 
+/// Task body equivalent of doUpdate(), registered with the #tasks scheduler by
+/// #init().  After each complete run it sets the task period to
+/// getUpdateRate().
+bool runTask();
+
 /// Returns the minimum amount of time that should elapse before the current
 /// display screen is updated again. This is customizable to allow for both
 /// fast-updating interactive screens (jog mode, etc) that can be used when
@@ -5,6 +5,7 @@
 #include "Timeout.hh"
 #include "Command.hh"
 #include "Motherboard.hh"
+#include "Profiler.hh"
 
 #if defined HAS_INTERFACE_BOARD
 
@@ -37,6 +38,7 @@ void InterfaceBoard::init() {
   onboard_start_idx = 1;
   sd_start_idx = 0;
   user_wait_override = false;
+  task_state = 0;
 }
 
 void InterfaceBoard::resetLCD() {
@@ -131,6 +133,33 @@ void InterfaceBoard::popToOnboardStart(){
 }
 
 void InterfaceBoard::doUpdate() {
+	PROFILE_SLICE(SLICE_INTERFACE);
+	handleInput();
+	drawScreen();
+}
+
+bool InterfaceBoard::runTask() {
+	// A run that resumes after a yield is part of the same call
+	PROFILE_SLICE_PART(SLICE_INTERFACE, task_state != 0);
+	TASK_BEGIN(task_state);
+	handleInput();
+	// Redrawing is the slow part; let anything more urgent run first
+	TASK_YIELD(task_state);
+	if (!screen_locked) {
+		buildScreen.setBuildPercentage(buildPercentage);
+		drawingScreen = screenStack[screenIndex];
+		drawStep = 0;
+		// Draw a step per slice.  Give up if the screen changes in between,
+		// as pushing or popping a screen redraws the new one in full.
+		while (!screen_locked && drawingScreen == screenStack[screenIndex] &&
+		       !drawingScreen->updateStep(lcd, drawStep++)) {
+			TASK_YIELD(task_state);
+		}
+	}
+	TASK_END(task_state);
+}
+
+void InterfaceBoard::handleInput() {
 
 		// If we are building, make sure we show a build menu; otherwise,
 		// turn it off.
@@ -212,7 +241,11 @@ void InterfaceBoard::doUpdate() {
             Motherboard::getBoard().resetUserInputTimeout();
 
         }
-       
+    }
+}
+
+void InterfaceBoard::drawScreen() {
+    if(!screen_locked){
         // update build data
         buildScreen.setBuildPercentage(buildPercentage);	
         screenStack[screenIndex]->update(lcd, false);
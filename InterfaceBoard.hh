@@ -23,6 +23,7 @@
 #include "Pin.hh"
 #include "ButtonArray.hh"
 #include "Menu.hh"
+#include "Task.hh"
 
 /// Maximum number of screens that can be active at once.
 #define SCREEN_STACK_DEPTH      7
@@ -81,6 +82,16 @@ private:
         
         uint8_t onboard_start_idx;		/// screen stack index when onboard script is started
         uint8_t sd_start_idx;			/// screen stack index when printing from SD card
+
+        task_state_t task_state;        ///< Resume point of runTask()
+        Screen* drawingScreen;          ///< Screen runTask() is part way through drawing
+        uint8_t drawStep;               ///< Next Screen::updateStep() of drawingScreen
+
+        /// Track the host state and pass button presses to the active screen.
+        void handleInput();
+
+        /// Redraw the active screen.
+        void drawScreen();
 public:
         /// Construct an interface board.
         /// \param[in] button array to read from
@@ -125,6 +136,13 @@ public:
 
         void doUpdate();
 
+        /// Same work as doUpdate(), written as a #Task body: it yields after
+        /// handling input and between the steps of redrawing the screen (see
+        /// Screen::updateStep()), so a slow LCD update does not hold up more
+        /// urgent tasks.
+        /// \return True once the screen has been redrawn
+        bool runTask();
+
         void showMonitorMode();
         
         /// Tell the interface board that the system is waiting for a button push
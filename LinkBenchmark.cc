@@ -0,0 +1,191 @@
+/// Host tool for the link benchmark: sends #HOST_CMD_DEBUG_ECHO_TIMED packets
+/// of each payload size to a board built with LINK_BENCHMARK, and prints the
+/// latency and throughput for each size.  It is not part of the firmware;
+/// build and run it on a Linux or macOS host with:
+///
+///     g++ -O2 -DHOST_TEST -o linkbench LinkBenchmark.cc
+///     ./linkbench /dev/ttyACM0 115200 [packets per size]
+///
+/// Run it once per baud rate to compare settings.  For each size the table
+/// gives:
+/// - the mean round trip seen by the host;
+/// - the mean time the board took to receive the packet, from the start
+///   byte to the last byte;
+/// - the mean time spent in the board's receive interrupt per packet;
+/// - the mean time from packet completion to the response being built;
+/// - the bytes on the wire in each direction per second of round trip.
+
+#ifdef HOST_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+#include <sys/time.h>
+
+#include "Commands.hh"
+
+static const uint8_t START_BYTE = 0xD5;
+static const uint8_t MAX_PAYLOAD = 32;
+static const uint8_t RC_OK = 0x81;
+/// Smallest request: the command byte and the host timestamp
+static const uint8_t MIN_PAYLOAD = 5;
+/// The response code and five uint32 values
+static const uint8_t REPORT_SIZE = 21;
+
+/// The packet CRC, as _crc_ibutton_update() in avr-libc
+static uint8_t crcUpdate(uint8_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 1) ? (crc >> 1) ^ 0x8C : (crc >> 1);
+	}
+	return crc;
+}
+
+static uint32_t nowMicros() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint32_t)(tv.tv_sec * 1000000ULL + tv.tv_usec);
+}
+
+static speed_t baudConstant(long baud) {
+	switch (baud) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+	default: return 0;
+	}
+}
+
+static int openPort(const char* path, long baud) {
+	int fd = open(path, O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	struct termios tio;
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, baudConstant(baud));
+	cfsetospeed(&tio, baudConstant(baud));
+	tio.c_cflag |= CLOCAL | CREAD;
+	tcsetattr(fd, TCSANOW, &tio);
+	tcflush(fd, TCIOFLUSH);
+	return fd;
+}
+
+/// Read one byte, waiting up to a second
+static bool readByte(int fd, uint8_t& b) {
+	struct pollfd p = { fd, POLLIN, 0 };
+	if (poll(&p, 1, 1000) <= 0) {
+		return false;
+	}
+	return read(fd, &b, 1) == 1;
+}
+
+/// Read a response packet
+/// \return Payload length, or -1 on a timeout or bad packet
+static int readPacket(int fd, uint8_t* payload) {
+	uint8_t b;
+	do {
+		if (!readByte(fd, b)) {
+			return -1;
+		}
+	} while (b != START_BYTE);
+	uint8_t length;
+	if (!readByte(fd, length) || length > MAX_PAYLOAD) {
+		return -1;
+	}
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < length; i++) {
+		if (!readByte(fd, payload[i])) {
+			return -1;
+		}
+		crc = crcUpdate(crc, payload[i]);
+	}
+	if (!readByte(fd, b) || b != crc) {
+		return -1;
+	}
+	return length;
+}
+
+static uint32_t get32(const uint8_t* p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 || baudConstant(atol(argv[2])) == 0) {
+		fprintf(stderr, "usage: %s port baud [packets per size]\n", argv[0]);
+		return 2;
+	}
+	long baud = atol(argv[2]);
+	int count = (argc > 3) ? atoi(argv[3]) : 100;
+	int fd = openPort(argv[1], baud);
+	if (fd < 0) {
+		return 1;
+	}
+
+	printf("# %s at %ld baud, %d packets per size, times in microseconds\n", argv[1], baud, count);
+	printf("# size  round_trip  board_rx  rx_isr  handler  lost  up_B/s  down_B/s\n");
+	for (uint8_t size = MIN_PAYLOAD; size <= MAX_PAYLOAD; size++) {
+		double round_trip = 0, board_rx = 0, isr = 0, handler = 0;
+		int good = 0;
+		for (int n = 0; n < count; n++) {
+			uint8_t packet[MAX_PAYLOAD + 3];
+			uint32_t stamp = nowMicros();
+			packet[0] = START_BYTE;
+			packet[1] = size;
+			packet[2] = HOST_CMD_DEBUG_ECHO_TIMED;
+			for (uint8_t i = 0; i < 4; i++) {
+				packet[3 + i] = (stamp >> (8 * i)) & 0xff;
+			}
+			memset(packet + 7, 0, size - MIN_PAYLOAD);
+			uint8_t crc = 0;
+			for (uint8_t i = 0; i < size; i++) {
+				crc = crcUpdate(crc, packet[2 + i]);
+			}
+			packet[2 + size] = crc;
+			if (write(fd, packet, size + 3) != size + 3) {
+				perror("write");
+				return 1;
+			}
+
+			uint8_t response[MAX_PAYLOAD];
+			int length = readPacket(fd, response);
+			uint32_t end = nowMicros();
+			if (length < REPORT_SIZE || response[0] != RC_OK || get32(response + 1) != stamp) {
+				// resynchronise after a lost or stale response
+				tcflush(fd, TCIFLUSH);
+				continue;
+			}
+			good++;
+			round_trip += end - stamp;
+			board_rx += get32(response + 9) - get32(response + 5);
+			isr += get32(response + 13);
+			handler += get32(response + 17);
+		}
+		if (good == 0) {
+			printf("%6u  no responses\n", size);
+			continue;
+		}
+		round_trip /= good;
+		// each way carries the payload plus the start, length and CRC bytes;
+		// the response is padded to the request size
+		uint8_t up = size + 3;
+		uint8_t down = (size > REPORT_SIZE ? size : REPORT_SIZE) + 3;
+		printf("%6u  %10.0f  %8.0f  %6.0f  %7.0f  %4d  %6.0f  %8.0f\n", size, round_trip,
+		       board_rx / good, isr / good, handler / good, count - good,
+		       up * 1e6 / round_trip, down * 1e6 / round_trip);
+	}
+	close(fd);
+	return 0;
+}
+
+#endif // HOST_TEST
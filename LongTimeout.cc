@@ -0,0 +1,65 @@
+#ifdef EXTENDED_CLOCK
+
+#include "LongTimeout.hh"
+#include "ExtendedClock.hh"
+
+LongTimeout::LongTimeout() : active(false), elapsed(false), is_paused(false) {}
+
+void LongTimeout::start(micros64_t duration_micros) {
+	active = true;
+	is_paused = false;
+	elapsed = false;
+	start_stamp_micros = extendedclock::getMicros();
+	deadline_micros = start_stamp_micros + duration_micros;
+}
+
+bool LongTimeout::hasElapsed() {
+	if (active && !elapsed && !is_paused) {
+		if (extendedclock::getMicros() >= deadline_micros) {
+			active = false;
+			elapsed = true;
+		}
+	}
+	return elapsed;
+}
+
+void LongTimeout::abort() {
+	active = false;
+}
+
+void LongTimeout::clear() {
+	elapsed = false;
+}
+
+void LongTimeout::pause(bool pause_in) {
+
+	/// don't update time or state if we are already in the desired state
+	if (is_paused != pause_in) {
+
+		is_paused = pause_in;
+		micros64_t now = extendedclock::getMicros();
+
+		// While paused, the stamps hold the elapsed time and the duration
+		if (pause_in) {
+			deadline_micros -= start_stamp_micros;
+			start_stamp_micros = now - start_stamp_micros;
+		} else {
+			start_stamp_micros = now - start_stamp_micros;
+			deadline_micros += start_stamp_micros;
+		}
+	}
+}
+
+micros64_t LongTimeout::getCurrentElapsed() {
+	if (active) {
+		if (is_paused) {
+			return start_stamp_micros;
+		} else {
+			return extendedclock::getMicros() - start_stamp_micros;
+		}
+	} else {
+		return 0;
+	}
+}
+
+#endif // EXTENDED_CLOCK
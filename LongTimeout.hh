@@ -0,0 +1,51 @@
+#ifndef LONG_TIMEOUT_HH_
+#define LONG_TIMEOUT_HH_
+
+#include "Types.hh"
+
+/// A one-shot timer like #Timeout, for periods longer than the 32-bit board
+/// clock can measure, such as the length of a build.  It runs from the
+/// #extendedclock and stores its deadline rather than a start time and
+/// duration, so checking it is a single comparison.  Like the clock, it is only
+/// available when the board defines EXTENDED_CLOCK.
+/// \ingroup SoftwareLibraries
+class LongTimeout {
+private:
+	bool active;			///< True if the timeout object is actively counting down.
+	bool elapsed;			///< True if the timeout object has elapsed.
+	bool is_paused;			///< True if the timeout object is paused
+
+	micros64_t start_stamp_micros;	///< Start time, or the time elapsed before the pause while paused
+	micros64_t deadline_micros;	///< Time at which the timeout elapses, or its duration while paused
+public:
+	/// Instantiate a new timeout object.
+	LongTimeout();
+
+	/// Start a new timeout cycle that will elapse after the given amount of time.
+	/// \param [in] duration_micros Microseconds until the timeout cycle should elapse.
+	void start(micros64_t duration_micros);
+
+	/// Test whether the current timeout cycle has elapsed.
+	/// \return True if the timeout has elapsed.
+	bool hasElapsed();
+
+	/// \return True if the timeout is still running.
+	bool isActive() const { return active; }
+
+	/// Stop the current timeout.
+	void abort();
+
+	/// Clear the timeout so it can be used again
+	void clear();
+
+	/// pause the timer
+	/// while paused, the timer will not increment
+	/// \param pause_in true to pause, false to unpause
+	void pause(bool pause_in);
+
+	/// get the microseconds elapsed since starting the timer
+	/// \return microseconds elapsed
+	micros64_t getCurrentElapsed();
+};
+
+#endif // LONG_TIMEOUT_HH_
@@ -22,6 +22,7 @@
 #include "RGB_LED.hh"
 #include "stdio.h"
 #include "Menu_locales.hh"
+#include "Profiler.hh"
 #include "Piezo.hh"
 #include "Main.hh"
 #include "StepperAccelPlanner.hh"
@@ -38,6 +39,7 @@ SettingsMenu set;
 StopHeightMenu height;
 PreheatSettingsMenu preheatSettings;
 ResetSettingsMenu reset_settings;
+AutotuneMenu autotune_confirm;
 NozzleCalibrationScreen alignment;
 HeaterPreheat preheat;
 UtilitiesMenu utils;
@@ -1246,18 +1248,29 @@ bool MessageScreen::screenWaiting(void){
   return (timeout.isActive() || incomplete || waiting_for_user);
 }
 
+// copy the message straight out of the buffer storage, consuming it up to and
+// including the terminator.  Text that does not fit on the screen is dropped.
 void MessageScreen::addMessage(CircularBuffer& buf) {
-  char c = buf.pop();
-  while (c != '\0' && cursor < BUF_SIZE && buf.getLength() > 0) {
-    message[cursor++] = c;
-    c = buf.pop();
+  bool terminated = false;
+  BufSizeType len;
+  uint8_t *chunk;
+
+  while (!terminated && (chunk = buf.peek_contiguous(len), len > 0)) {
+    uint8_t *end = (uint8_t *)memchr(chunk, '\0', len);
+    if (end != NULL) {
+      len = end - chunk;
+      terminated = true;
+    }
+    BufSizeType copy = (cursor < BUF_SIZE - 1) ? BUF_SIZE - 1 - cursor : 0;
+    if (copy > len) {
+      copy = len;
+    }
+    memcpy(message + cursor, chunk, copy);
+    cursor += copy;
+    buf.pop(terminated ? len + 1 : len);
   }
   // ensure that message is always null-terminated
-  if (cursor == BUF_SIZE-1) {
-    message[BUF_SIZE-1] = '\0';
-  } else {
-    message[cursor] = '\0';
-  }
+  message[cursor] = '\0';
 }
 
 // this method is to process messages in program memory
@@ -1614,6 +1627,7 @@ void MonitorMode::reset() {
   buildPercentage = 101;
   singleTool = eeprom::isSingleTool();
   heating = false;
+  show_eta = false;
   hasHBP = eeprom::hasHBP();
   if(hasHBP){
     num_update_phases = 6;
@@ -1630,6 +1644,21 @@ void MonitorMode::setBuildPercentage(uint8_t percent){
 bool display_time = 0;
 bool two_digit_hours = 0;
 
+bool MonitorMode::drawHeatupEta(LiquidCrystalSerial& lcd, Heater& heater, uint8_t row) {
+  if(!show_eta){
+    return false;
+  }
+  uint16_t eta = heater.getHeatupEta();
+  if(eta == 0 || eta > 999){
+    return false;
+  }
+  lcd.setCursor(15,row);
+  lcd.writeFromPgmspace(ETA_SECONDS_MSG);
+  lcd.setCursor(16,row);
+  lcd.writeInt(eta,3);
+  return true;
+}
+
 void MonitorMode::update(LiquidCrystalSerial& lcd, bool forceRedraw) {
   uint8_t build_hours;
   uint8_t build_minutes;
@@ -1782,12 +1811,12 @@ void MonitorMode::update(LiquidCrystalSerial& lcd, bool forceRedraw) {
     if(!singleTool){
        if(!board.getExtruderBoard(0).getExtruderHeater().has_failed() && !board.getExtruderBoard(0).getExtruderHeater().isPaused()){           
           data = board.getExtruderBoard(0).getExtruderHeater().get_set_temperature();
-          if(data > 0){
+          if(data > 0 && !drawHeatupEta(lcd, board.getExtruderBoard(0).getExtruderHeater(), 1)){
             lcd.setCursor(15,1);
             lcd.writeFromPgmspace(ON_CELCIUS_MSG);
             lcd.setCursor(16,1);
             lcd.writeInt(data,3);
-          }else{
+          }else if(data == 0){
             lcd.setCursor(15,1);
             lcd.writeFromPgmspace(CELCIUS_MSG);
           }
@@ -1811,12 +1840,12 @@ void MonitorMode::update(LiquidCrystalSerial& lcd, bool forceRedraw) {
         if(!board.getExtruderBoard(!singleTool * 1).getExtruderHeater().has_failed() && !board.getExtruderBoard(!singleTool * 1).getExtruderHeater().isPaused()){
             lcd.setCursor(16,2);
             data = board.getExtruderBoard(!singleTool * 1).getExtruderHeater().get_set_temperature();
-            if(data > 0){
+            if(data > 0 && !drawHeatupEta(lcd, board.getExtruderBoard(!singleTool * 1).getExtruderHeater(), 2)){
                 lcd.setCursor(15,2);
                 lcd.writeFromPgmspace(ON_CELCIUS_MSG);
                 lcd.setCursor(16,2);
                 lcd.writeInt(data,3);
-            }else{
+            }else if(data == 0){
                 lcd.setCursor(15,2);
                 lcd.writeFromPgmspace(CELCIUS_MSG);
             }
@@ -1839,19 +1868,20 @@ void MonitorMode::update(LiquidCrystalSerial& lcd, bool forceRedraw) {
         if(!board.getPlatformHeater().has_failed() && !board.getPlatformHeater().isPaused()){
             lcd.setCursor(16,3);
             data = board.getPlatformHeater().get_set_temperature();
-            if(data > 0){
+            if(data > 0 && !drawHeatupEta(lcd, board.getPlatformHeater(), 3)){
                 lcd.setCursor(15,3);
                 lcd.writeFromPgmspace(ON_CELCIUS_MSG);
                 lcd.setCursor(16,3);
                 lcd.writeInt(data,3);
             }
-            else{
+            else if(data == 0){
                 lcd.setCursor(15,3);
                 lcd.writeFromPgmspace(CELCIUS_MSG);
             }
         }
     break;
   case 0:
+    show_eta = !show_eta;
     host::HostState state;
     state = host::getHostState();
     if(!heating && ((state == host::HOST_STATE_BUILDING) || (state == host::HOST_STATE_BUILDING_FROM_SD)))
@@ -1924,41 +1954,55 @@ void MonitorMode::notifyButtonPressed(ButtonArray::ButtonName button) {
 
 
 void Menu::update(LiquidCrystalSerial& lcd, bool forceRedraw) {
-
-  /// write the non-menu item lines
-  if (forceRedraw || needsRedraw){
-    // Redraw the whole menu
-    lcd.clear();
-    for (uint8_t i = 0; i < firstItemIndex; i++) {
-      lcd.setCursor(1,i);
-      drawItem(i, lcd, i); 
-    }
+  if (forceRedraw) {
+    needsRedraw = true;
   }
-  
-  // Do we need to redraw the whole menu?
-  if((!sliding_menu && (itemIndex/LCD_SCREEN_HEIGHT) != (lastDrawIndex/LCD_SCREEN_HEIGHT)) ||
-      (zeroIndex != lastZeroIndex) || forceRedraw || needsRedraw){
-        
-    if(!sliding_menu){
-      lcd.clear();
-    }
+  uint8_t step = 0;
+  while (!updateStep(lcd, step++)) {
+  }
+}
 
-    for (uint8_t i = firstItemIndex; i < LCD_SCREEN_HEIGHT; i++) {
-      // Instead of using lcd.clear(), clear one line at a time so there
-      // is less screen flickr.
+bool Menu::updateStep(LiquidCrystalSerial& lcd, uint8_t step) {
 
-      if ((zeroIndex == 0) && ( i+(itemIndex/LCD_SCREEN_HEIGHT)*LCD_SCREEN_HEIGHT +1 > itemCount)) {
-        break;
+  if (step == 0) {
+    /// write the non-menu item lines
+    if (needsRedraw){
+      // Redraw the whole menu
+      lcd.clear();
+      for (uint8_t i = 0; i < firstItemIndex; i++) {
+        lcd.setCursor(1,i);
+        drawItem(i, lcd, i); 
       }
+    }
 
-      lcd.setCursor(1,i);
-      if(sliding_menu){
-        // Draw one page of items at a time
-        drawItem(i + zeroIndex, lcd, i);
-      }else{
-        drawItem(i+(itemIndex/LCD_SCREEN_HEIGHT)*LCD_SCREEN_HEIGHT, lcd, i);
-      }
+    // Do we need to redraw the whole menu?  The later steps follow this
+    // decision, even if the menu changes part way through the redraw.
+    redrawItems = (!sliding_menu && (itemIndex/LCD_SCREEN_HEIGHT) != (lastDrawIndex/LCD_SCREEN_HEIGHT)) ||
+      (zeroIndex != lastZeroIndex) || needsRedraw;
+    if (redrawItems && !sliding_menu) {
+      lcd.clear();
     }
+    return false;
+  }
+
+  // Steps from 1 draw one item line each
+  uint8_t i = firstItemIndex + step - 1;
+  if (redrawItems && i < LCD_SCREEN_HEIGHT &&
+      !((zeroIndex == 0) && ( i+(itemIndex/LCD_SCREEN_HEIGHT)*LCD_SCREEN_HEIGHT +1 > itemCount))) {
+    // Instead of using lcd.clear(), clear one line at a time so there
+    // is less screen flickr.
+    lcd.setCursor(1,i);
+    if(sliding_menu){
+      // Draw one page of items at a time
+      drawItem(i + zeroIndex, lcd, i);
+    }else{
+      drawItem(i+(itemIndex/LCD_SCREEN_HEIGHT)*LCD_SCREEN_HEIGHT, lcd, i);
+    }
+    return false;
+  }
+
+  // The last step draws the cursor
+  if (redrawItems) {
     cursorUpdate = true;
   }
   else if (lineUpdate){
@@ -1984,6 +2028,8 @@ void Menu::update(LiquidCrystalSerial& lcd, bool forceRedraw) {
   lineUpdate = false;
   cursorUpdate = false;
     needsRedraw = false;
+  redrawItems = false;
+  return true;
 }
 
 void Menu::reset() {
@@ -1993,6 +2039,7 @@ void Menu::reset() {
   itemIndex = 0;
   lastDrawIndex = 255;
   lineUpdate = false;
+  redrawItems = false;
   sliding_menu = true;
   resetState();
     needsRedraw = false;
@@ -2274,6 +2321,50 @@ void ResetSettingsMenu::handleSelect(uint8_t index) {
   }
 }
 
+AutotuneMenu::AutotuneMenu() {
+  itemCount = 4;
+  reset();
+}
+
+void AutotuneMenu::resetState() {
+  itemIndex = 2;
+  firstItemIndex = 2;
+}
+
+void AutotuneMenu::drawItem(uint8_t index, LiquidCrystalSerial& lcd, uint8_t line_number) {
+    
+  switch (index) {
+        case 0:
+            lcd.writeFromPgmspace(AUTOTUNE1_MSG);
+            break;
+        case 1:
+            lcd.writeFromPgmspace(AUTOTUNE2_MSG);
+            break;
+        case 2:
+            lcd.writeFromPgmspace(NO_MSG);
+            break;
+        case 3:
+            lcd.writeFromPgmspace(YES_MSG);
+            break;
+  }
+}
+
+void AutotuneMenu::handleSelect(uint8_t index) {
+  switch (index) {
+        case 2:
+            // Don't tune, just close dialog.
+            interface::popScreen();
+            break;
+        case 3:
+            // tune the right extruder heater at its preheat temperature, and show its progress
+            Motherboard::getBoard().getExtruderBoard(0).getExtruderHeater().startAutotune(
+                eeprom::getEeprom16(eeprom_offsets::PREHEAT_SETTINGS + preheat_eeprom_offsets::PREHEAT_RIGHT_TEMP, 230));
+            interface::popScreen();
+            interface::queueScreen(InterfaceBoard::BUILD_SCREEN);
+            break;
+  }
+}
+
 #ifdef ACTIVE_COOLING_FAN
   const static uint8_t FanIdx = 5;
 #else
@@ -2666,15 +2757,46 @@ void BotStats::update(LiquidCrystalSerial& lcd, bool forceRedraw){
     lcd.writeInt(build_minutes,2);
 
     
-#ifdef STACK_PAINT
+#if defined STACK_PAINT && !defined PROFILER
     lcd.setCursor(0,3);
     lcd.writeString((char *)"Free SRAM ");
     lcd.writeFloat((float)StackCount(), 0, LCD_SCREEN_WIDTH);
 #endif
   }
+
+#ifdef PROFILER
+  /// main loop profile of the selected slice: average and longest run in microseconds
+  const profiler::SliceStats& stats = profiler::getStats((profiler::Slice)profile_slice);
+  uint32_t average = (stats.calls == 0) ? 0 : stats.total_micros / stats.calls;
+
+  lcd.setCursor(0,3);
+  switch (profile_slice) {
+  case profiler::SLICE_HOST:
+    lcd.writeFromPgmspace(PROFILE_HOST_MSG);
+    break;
+  case profiler::SLICE_COMMAND:
+    lcd.writeFromPgmspace(PROFILE_COMMAND_MSG);
+    break;
+  case profiler::SLICE_INTERFACE:
+    lcd.writeFromPgmspace(PROFILE_INTERFACE_MSG);
+    break;
+  case profiler::SLICE_HEATERS:
+    lcd.writeFromPgmspace(PROFILE_HEATERS_MSG);
+    break;
+  default:
+    lcd.writeFromPgmspace(PROFILE_SD_MSG);
+    break;
+  }
+  lcd.writeInt32(average, 6);
+  lcd.write(' ');
+  lcd.writeInt32(stats.max_micros, 8);
+#endif
 }
 
 void BotStats::reset(){
+#ifdef PROFILER
+  profile_slice = 0;
+#endif
 }
 
 void BotStats::notifyButtonPressed(ButtonArray::ButtonName button){
@@ -2685,10 +2807,22 @@ void BotStats::notifyButtonPressed(ButtonArray::ButtonName button){
         case ButtonArray::LEFT:
       interface::popScreen();
       break;
+#ifdef PROFILER
+        case ButtonArray::UP:
+      profile_slice = (profile_slice == 0) ? profiler::SLICE_COUNT - 1 : profile_slice - 1;
+      break;
+        case ButtonArray::DOWN:
+      profile_slice = (profile_slice + 1) % profiler::SLICE_COUNT;
+      break;
+        case ButtonArray::RIGHT:
+      profiler::reset();
+      break;
+#else
         case ButtonArray::RIGHT:
         case ButtonArray::DOWN:
         case ButtonArray::UP:
       break;
+#endif
   }
 }
   
@@ -2808,7 +2942,7 @@ void MainMenu::handleSelect(uint8_t index) {
 
 
 UtilitiesMenu::UtilitiesMenu() {
-  itemCount = 9;
+  itemCount = 10;
   stepperEnable = false;
   blinkLED = false;
   reset();
@@ -2816,9 +2950,9 @@ UtilitiesMenu::UtilitiesMenu() {
 void UtilitiesMenu::resetState(){
   singleTool = eeprom::isSingleTool();
   if(singleTool){
-    itemCount = 9;
-  }else{
     itemCount = 10;
+  }else{
+    itemCount = 11;
   }
 }
 
@@ -2859,12 +2993,15 @@ void UtilitiesMenu::drawItem(uint8_t index, LiquidCrystalSerial& lcd, uint8_t li
       lcd.writeFromPgmspace(LED_BLINK_MSG);
     break;
   case 8:
+    lcd.writeFromPgmspace(AUTOTUNE_MSG);
+    break;
+  case 9:
       if(!singleTool){
         lcd.writeFromPgmspace(NOZZLES_MSG);
       }else{
         lcd.writeFromPgmspace(EXIT_MSG);
       }break;
-  case 9:
+  case 10:
     if(!singleTool){
       lcd.writeFromPgmspace(EXIT_MSG);
     }break;
@@ -2913,13 +3050,17 @@ void UtilitiesMenu::handleSelect(uint8_t index) {
       lineUpdate = true;     
        break;
     case 8:
+      // autotune heater, after confirming
+      interface::pushScreen(&autotune_confirm);
+      break;
+    case 9:
       if(!singleTool){
         interface::pushScreen(&alignment);
       }else{
         interface::popScreen();
       }
       break;
-   case 9:
+   case 10:
      if(!singleTool){
         interface::popScreen();
      }
@@ -10,6 +10,7 @@
 #include "Host.hh"
 #include "UtilityScripts.hh"
 #include "Point.hh"
+#include "Heater.hh"
 
 
 /// this puts a max value on the number of items per menu
@@ -88,6 +89,19 @@ public:
         ///                        only updated sections need to be redrawn.
 	virtual void update(LiquidCrystalSerial& lcd, bool forceRedraw) = 0;
 
+        /// Do one step of an update, for callers that spread the redraw over
+        /// several main loop slices.  Call with steps counting up from 0 until
+        /// it returns true; the steps together do the work of
+        /// update(lcd, false).  Screens that do not split their drawing do it
+        /// all in step 0.
+        /// \param[in] lcd LCD to write to
+        /// \param[in] step Step to draw, counting from 0 for each update
+        /// \return True if this was the last step of the update
+	virtual bool updateStep(LiquidCrystalSerial& lcd, uint8_t step) {
+		update(lcd, false);
+		return true;
+	}
+
         /// Reset the screen to it's default state
 	virtual void reset() = 0;
 
@@ -114,6 +128,10 @@ public:
 
 	void update(LiquidCrystalSerial& lcd, bool forceRedraw);
 
+	/// Works out what to redraw in step 0, then draws one item line per
+	/// step, and the cursor last.
+	bool updateStep(LiquidCrystalSerial& lcd, uint8_t step);
+
 	void reset();
 
 	virtual void resetState();
@@ -125,6 +143,7 @@ protected:
 	bool needsRedraw;               ///< set to true if a menu item changes out of sequence
 	bool lineUpdate;				///< flags the menu to update the current line
 	bool cursorUpdate;				///< flag to update the menu cursor
+	bool redrawItems;				///< the update in progress redraws every item line
 	volatile uint8_t itemIndex;     ///< The currently selected item
 	uint8_t lastDrawIndex;          ///< The index used to make the last draw
 	volatile uint8_t zeroIndex;     ///< The index corresponding to the zeroth display line
@@ -263,6 +282,9 @@ public:
 class BotStats: public Screen {
 
 private:
+#ifdef PROFILER
+	uint8_t profile_slice;		///< main loop slice shown on the last line
+#endif
 
 public:
 
@@ -558,6 +580,20 @@ protected:
 	void handleSelect(uint8_t index);
 };
 
+/// Asks before starting a heater autotune, which heats the tool and
+/// overwrites its stored PID gains
+class AutotuneMenu: public Menu {
+public:
+	AutotuneMenu();
+    
+	void resetState();
+    
+protected:
+	void drawItem(uint8_t index, LiquidCrystalSerial& lcd, uint8_t line_number);
+    
+	void handleSelect(uint8_t index);
+};
+
 class MonitorMode: public Screen {
 private:
 	uint8_t updatePhase;
@@ -565,7 +601,12 @@ private:
 	bool singleTool; 
 	bool heating;
 	bool hasHBP;
+	bool show_eta;				///< alternate the set temperatures with heat-up estimates
 	uint8_t num_update_phases;
+
+	/// show the time a heater needs to reach its target in place of the target
+	/// \return true if an estimate was drawn
+	bool drawHeatupEta(LiquidCrystalSerial& lcd, Heater& heater, uint8_t row);
     
 public:
 	micros_t getUpdateRate() {return 500L * 1000L;}
@@ -19,6 +19,7 @@ static PROGMEM unsigned char NA2_MSG[] =				"NA ";
 
 static PROGMEM unsigned char ON_CELCIUS_MSG[] =				"/   C";
 static PROGMEM unsigned char CELCIUS_MSG[] =				"C    ";
+static PROGMEM unsigned char ETA_SECONDS_MSG[] =			"~   s";
 static PROGMEM unsigned char ARROW_MSG[] =				"-->";
 static PROGMEM unsigned char NO_ARROW_MSG[] =				"   ";
 static PROGMEM unsigned char BLANK_CHAR_MSG[] =				" ";
@@ -26,6 +27,18 @@ static PROGMEM unsigned char BLANK_CHAR_MSG[] =				" ";
 static PROGMEM unsigned char CLEAR_MSG[] =				"                    ";
 static PROGMEM unsigned char BLANKLINE_MSG[] =				"                ";
 
+// Not translated yet, so shared by every locale
+static PROGMEM unsigned char AUTOTUNE_MSG[] =				"Autotune Heater    ";
+static PROGMEM unsigned char AUTOTUNE1_MSG[] =				"Heat the right tool";
+static PROGMEM unsigned char AUTOTUNE2_MSG[] =				"and tune its PID?";
+
+// Main loop profiler slice names, in profiler::Slice order
+static PROGMEM unsigned char PROFILE_HOST_MSG[] =			"HOST ";
+static PROGMEM unsigned char PROFILE_COMMAND_MSG[] =			"CMD  ";
+static PROGMEM unsigned char PROFILE_INTERFACE_MSG[] =			"LCD  ";
+static PROGMEM unsigned char PROFILE_HEATERS_MSG[] =			"HEAT ";
+static PROGMEM unsigned char PROFILE_SD_MSG[] =				"SD   ";
+
 #ifdef LOCALE_FR
 #include "Menu.FR.hh"
 #else // Use US ENGLISH as default
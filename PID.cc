@@ -24,12 +24,15 @@
 
 #include "PID.hh"
 
-#define ERR_ACC_MAX 256
+#define ERR_ACC_MAX (256 << TEMPERATURE_FRACTION_BITS)
 #define ERR_ACC_MIN -ERR_ACC_MAX
 
 // scale the output term to account for our fixed-point bounds
 #define OUTPUT_SCALE 2
 
+// largest unscaled output that fits in an int once scaled
+#define OUTPUT_MAX (0x7fff / OUTPUT_SCALE)
+
 PID::PID() {
     reset();
 }
@@ -53,6 +56,10 @@ void PID::reset_state() {
 	delta_summation = 0;
 
 	last_output = 0;
+	last_output_fine = 0;
+#ifdef HEATER_TELEMETRY
+	last_p_term = last_i_term = last_d_term = 0;
+#endif
 }
 
 // We're modifying the way we compute delta by averaging the deltas over a
@@ -61,35 +68,131 @@ void PID::reset_state() {
 // which will give us a delta impulse for that one calculation round and then
 // the D term will immediately disappear.  By averaging the last N deltas, we
 // allow changes to be registered rather than get subsumed in the sampling noise.
-int PID::calculate(const int pv) {
-	int e = sp - pv;
-	error_acc += e;
-	// Clamp the error accumulator at accepted values.
-	// This will help control overcorrection for accumulated error during the run-up
-	// and allow the I term to be integrated away more quickly as we approach the
-	// setpoint.
-	if (error_acc > ERR_ACC_MAX) {
-		error_acc = ERR_ACC_MAX;
-	}
-	if (error_acc < ERR_ACC_MIN) {
-		error_acc = ERR_ACC_MIN;
-	}
-	float p_term = (float)e * p_gain;
-	float i_term = (float)error_acc * i_gain;
-	int delta = e - prev_error;
-	// Add to delta history
-	delta_summation -= delta_history[delta_idx];
-	delta_history[delta_idx] = delta;
-	delta_summation += (float)delta;
+// Now that the process value carries a fraction of a degree the steps are much
+// smaller, but the window is kept, since the D gain is tuned for it.
+int PID::calculateSixteenths(const int pv) {
+	int e = (sp << TEMPERATURE_FRACTION_BITS) - pv;
+	int32_t terms[3];
+	int32_t sum = calculateSum(e, p_gain, i_gain, d_gain,
+	                           error_acc, prev_error, delta_summation,
+	                           delta_history[delta_idx], terms);
 	delta_idx = (delta_idx+1) % DELTA_SAMPLES;
-	// Use the delta over the whole window
-	float d_term = delta_summation * d_gain;
+
+	last_output = scaleOutput(sum);
+	last_output_fine = scaleOutputFine(sum);
+#ifdef HEATER_TELEMETRY
+	last_p_term = termToOutput(terms[0]);
+	last_i_term = termToOutput(terms[1]);
+	last_d_term = termToOutput(terms[2]);
+#endif
+
+	return last_output;
+}
+
+int32_t PID::calculateSum(const int e,
+                          const uint16_t p_gain, const uint16_t i_gain, const uint16_t d_gain,
+                          int& error_acc, int& prev_error, int& delta_summation,
+                          int16_t& delta_slot, int32_t* terms) {
+	error_acc = clampErrorAccumulator(error_acc + e);
+	int delta = e - prev_error;
+	// Replace the oldest delta in the history
+	delta_summation -= delta_slot;
+	delta_slot = delta;
+	delta_summation += delta;
 
 	prev_error = e;
 
-	last_output = ((int)(p_term + i_term + d_term))*OUTPUT_SCALE;
+#ifdef PID_FLOAT
+	const float one = 1 << TEMPERATURE_FRACTION_BITS;
+	float p_term = (float)e / one * ((float)p_gain / 256.0);
+	float i_term = (float)error_acc / one * ((float)i_gain / 256.0);
+	// Use the delta over the whole window
+	float d_term = (float)delta_summation / one * ((float)d_gain / 256.0);
 
-	return last_output;
+	if (terms) {
+		terms[0] = (int32_t)(p_term * 256);
+		terms[1] = (int32_t)(i_term * 256);
+		terms[2] = (int32_t)(d_term * 256);
+	}
+	return (int32_t)((p_term + i_term + d_term) * 256);
+#else
+	// The terms also carry the temperature fraction.  Dropping it from the
+	// sum, rather than from each term, rounds as the float version does.
+	const int32_t one = 1 << TEMPERATURE_FRACTION_BITS;
+	int32_t p_term = (int32_t)e * p_gain;
+	int32_t i_term = (int32_t)error_acc * i_gain;
+	int32_t d_term = (int32_t)delta_summation * d_gain;
+
+	if (terms) {
+		terms[0] = p_term / one;
+		terms[1] = i_term / one;
+		terms[2] = d_term / one;
+	}
+	return (p_term + i_term + d_term) / one;
+#endif
+}
+
+// Clamp the error accumulator at accepted values.
+// This will help control overcorrection for accumulated error during the run-up
+// and allow the I term to be integrated away more quickly as we approach the
+// setpoint.
+int PID::clampErrorAccumulator(const int acc) {
+	if (acc > ERR_ACC_MAX) {
+		return ERR_ACC_MAX;
+	}
+	if (acc < ERR_ACC_MIN) {
+		return ERR_ACC_MIN;
+	}
+	return acc;
+}
+
+int PID::scaleOutput(int32_t sum) {
+	// The gains carry 8 fractional bits, so the sum of the terms does too.
+	// Dividing (rather than shifting) truncates towards zero, as the float
+	// to int conversion does.
+	sum /= 256;
+	// Saturate rather than wrap when the scaled output is out of range
+	if (sum > OUTPUT_MAX) {
+		sum = OUTPUT_MAX;
+	}
+	if (sum < -OUTPUT_MAX) {
+		sum = -OUTPUT_MAX;
+	}
+	return ((int)sum)*OUTPUT_SCALE;
+}
+
+int32_t PID::scaleOutputFine(int32_t sum) {
+	const int32_t max = (int32_t)OUTPUT_MAX * 256;
+	if (sum > max) {
+		sum = max;
+	}
+	if (sum < -max) {
+		sum = -max;
+	}
+	return sum * OUTPUT_SCALE;
+}
+
+#ifdef HEATER_TELEMETRY
+int16_t PID::termToOutput(const int32_t term) {
+	int32_t scaled = term / 256;
+	if (scaled > OUTPUT_MAX) {
+		scaled = OUTPUT_MAX;
+	}
+	if (scaled < -OUTPUT_MAX) {
+		scaled = -OUTPUT_MAX;
+	}
+	return (int16_t)scaled * OUTPUT_SCALE;
+}
+#endif
+
+uint16_t PID::toFixed16(const float gain) {
+	if (gain <= 0) {
+		return 0;
+	}
+	if (gain >= 65535.0 / 256.0) {
+		return 0xffff;
+	}
+	return PID_FIXED16(gain);
 }
 
 void PID::setTarget(const int target) {
@@ -100,11 +203,11 @@ void PID::setTarget(const int target) {
 }
 
 int PID::getErrorTerm() {
-	return error_acc;
+	return error_acc / (1 << TEMPERATURE_FRACTION_BITS);
 }
 
 int PID::getDeltaTerm() {
-	return (int)delta_summation;
+	return delta_summation / (1 << TEMPERATURE_FRACTION_BITS);
 }
 
 int PID::getLastOutput() {
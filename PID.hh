@@ -25,28 +25,57 @@
 #define PID_HH_
 
 #include <stdint.h>
+#include "Types.hh"
 
 /// Number of delta samples to
 #define DELTA_SAMPLES 4
 
+/// Convert a gain to the fixed16 format used by the PID controller and stored
+/// in EEPROM: unsigned 8.8 fixed point, so the integer part is the high byte.
+#define PID_FIXED16(gain) ((uint16_t)((gain) * 256.0 + 0.5))
+
 /// The PID controller module implements a simple PID controller.
+/// The gains are held in the fixed16 (8.8 fixed point) format, and each cycle
+/// is calculated in integer arithmetic.  Build with PID_FLOAT to use the
+/// original floating point calculation instead, which gives the same output
+/// for gains that are exact in fixed16.
+///
+/// The process value is taken in sixteenths of a degree (see
+/// #TEMPERATURE_FRACTION_BITS), and the loop state is kept in the same units,
+/// so the gains still act per whole degree of error.
 /// \ingroup SoftwareLibraries
 class PID {
 private:
-    float p_gain; ///< proportional gain
-    float i_gain; ///< integral gain
-    float d_gain; ///< derivative gain
+    uint16_t p_gain; ///< proportional gain, fixed16
+    uint16_t i_gain; ///< integral gain, fixed16
+    uint16_t d_gain; ///< derivative gain, fixed16
 
     /// Data for approximating d (smoothing to handle discrete nature of sampling).
-    /// See PID.cc for a description of why we do this.
+    /// See PID.cc for a description of why we do this.  In sixteenths of a degree.
     int16_t delta_history[DELTA_SAMPLES];
-    float delta_summation;      ///< ?
+    int delta_summation;        ///< Sum of the delta history, in sixteenths
     uint8_t delta_idx;          ///< Current index in the delta history buffer
-    int prev_error;             ///< Previous input for calculating next delta
-    int error_acc;              ///< Accumulated error, for calculating integral
+    int prev_error;             ///< Previous error for calculating next delta, in sixteenths
+    int error_acc;              ///< Accumulated error, for calculating integral, in sixteenths
 
     int sp;                     ///< Process set point
     int last_output;            ///< Last output of the PID controller
+    int32_t last_output_fine;   ///< The same, with 8 fractional bits
+
+#ifdef HEATER_TELEMETRY
+    int16_t last_p_term;        ///< Proportional part of the last output
+    int16_t last_i_term;        ///< Integral part of the last output
+    int16_t last_d_term;        ///< Derivative part of the last output
+#endif
+
+    /// Convert a floating point gain to fixed16, clamping it to the range
+    /// the format can hold
+    static uint16_t toFixed16(const float gain);
+
+#ifdef HEATER_TELEMETRY
+    /// Convert a term with 8 fractional bits to output units, as the output is
+    static int16_t termToOutput(const int32_t term);
+#endif
 
 public:
     /// Initialize the PID module
@@ -54,15 +83,23 @@ public:
 
     /// Set the P term of the PID controller
     /// \param[in] p_gain_in New proportional gain term
-    void setPGain(const float p_gain_in) { p_gain = p_gain_in; }
+    void setPGain(const float p_gain_in) { p_gain = toFixed16(p_gain_in); }
 
     /// Set the I term of the PID controller
     /// \param[in] i_gain_in New integration gain term
-    void setIGain(const float i_gain_in) { i_gain = i_gain_in; }
+    void setIGain(const float i_gain_in) { i_gain = toFixed16(i_gain_in); }
 
     /// Set the D term of the PID controller
     /// \param[in] d_gain_in New derivative gain term
-    void setDGain(const float d_gain_in) { d_gain = d_gain_in; }
+    void setDGain(const float d_gain_in) { d_gain = toFixed16(d_gain_in); }
+
+    /// Set all three gains from their fixed16 encoding, as read from EEPROM
+    /// \param[in] p_gain_in New proportional gain term
+    /// \param[in] i_gain_in New integration gain term
+    /// \param[in] d_gain_in New derivative gain term
+    void setGainsFixed16(const uint16_t p_gain_in, const uint16_t i_gain_in, const uint16_t d_gain_in) {
+        p_gain = p_gain_in; i_gain = i_gain_in; d_gain = d_gain_in;
+    }
 
     /// Set the setpoint of the PID controller
     /// \param[in] target New PID controller target
@@ -79,21 +116,84 @@ public:
     void reset_state();
 
     /// Calculate the next cycle of the PID loop.
-    /// \param[in] pv Process value (measured value from the sensor)
+    /// \param[in] pv Process value (measured value from the sensor), in whole degrees
     /// \return output value (used to control the output)
-    int calculate(int pv);
+    int calculate(int pv) { return calculateSixteenths(pv << TEMPERATURE_FRACTION_BITS); }
+
+    /// Calculate the next cycle of the PID loop from a fixed point process value.
+    /// \param[in] pv Process value, in sixteenths of a degree
+    /// \return output value (used to control the output)
+    int calculateSixteenths(int pv);
 
     /// Get the current value of the error term
-    /// \return Error term
+    /// \return Error term, in whole degrees
     int getErrorTerm();
 
     /// Get the current value of the delta term
-    /// \return Delta term
+    /// \return Delta term, in whole degrees
     int getDeltaTerm();
 
     /// Get the last process output value
     /// \return Last process output value
     int getLastOutput();
+
+    /// Get the last process output value without truncating its fraction, for
+    /// outputs that have more than 8 bits of resolution
+    /// \return Last process output value, with 8 fractional bits
+    int32_t getLastOutputFine() const { return last_output_fine; }
+
+    /// Run one cycle of the PID arithmetic on loop state held by the caller.
+    /// #calculateSixteenths() uses it on the object's own state, and
+    /// controllers that keep the state of several loops together, such as the
+    /// #HeaterBank, on theirs.  Build with PID_FLOAT to use the floating point
+    /// calculation.
+    /// \param[in] e Error, in sixteenths of a degree
+    /// \param[in] p_gain Proportional gain, fixed16
+    /// \param[in] i_gain Integral gain, fixed16
+    /// \param[in] d_gain Derivative gain, fixed16
+    /// \param[in,out] error_acc Accumulated error, in sixteenths
+    /// \param[in,out] prev_error Error of the previous cycle, in sixteenths
+    /// \param[in,out] delta_summation Sum of the delta history, in sixteenths
+    /// \param[in,out] delta_slot Oldest entry of the delta history, replaced
+    ///                 by this cycle's delta; the caller advances its index
+    /// \param[out] terms If not null, the P, I and D parts of the sum, in the
+    ///                   same units
+    /// \return Sum of the gain * term products for whole degree terms, with 8
+    ///         fractional bits, as #scaleOutput() takes
+    static int32_t calculateSum(const int e,
+                                const uint16_t p_gain, const uint16_t i_gain, const uint16_t d_gain,
+                                int& error_acc, int& prev_error, int& delta_summation,
+                                int16_t& delta_slot, int32_t* terms = 0);
+
+    /// Clamp an error accumulator to the range the integral term may use.
+    /// Shared with controllers that keep their own loop state, such as the
+    /// #HeaterBank.
+    /// \param[in] acc Accumulated error, in sixteenths of a degree
+    /// \return Clamped accumulated error
+    static int clampErrorAccumulator(const int acc);
+
+    /// Convert a sum of fixed16 terms into a controller output
+    /// \param[in] sum Sum of the gain * term products for whole degree terms,
+    ///                with 8 fractional bits
+    /// \return Saturated output, in the units #calculate() returns
+    static int scaleOutput(int32_t sum);
+
+    /// Convert a sum of fixed16 terms into a controller output, keeping the
+    /// fraction
+    /// \param[in] sum Sum of the gain * term products for whole degree terms,
+    ///                with 8 fractional bits
+    /// \return Saturated output, with 8 fractional bits
+    static int32_t scaleOutputFine(int32_t sum);
+
+#ifdef HEATER_TELEMETRY
+    /// Get the parts of the last output due to each term, in output units
+    /// \param[out] p Proportional part
+    /// \param[out] i Integral part
+    /// \param[out] d Derivative part
+    void getLastTerms(int16_t& p, int16_t& i, int16_t& d) const {
+        p = last_p_term; i = last_i_term; d = last_d_term;
+    }
+#endif
 };
 
 #endif /* PID_HH_ */
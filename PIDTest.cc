@@ -0,0 +1,115 @@
+/// Host equivalence test and benchmark of the fixed point #PID against the
+/// floating point reference built with PID_FLOAT.  It is not part of the
+/// firmware; build and run it on the host with:
+///
+///     g++ -O2 -DPID_FLOAT -DPID=FloatPID -c PID.cc -o PIDFloat.o
+///     g++ -O2 -DHOST_TEST -o pidtest PIDTest.cc PID.cc PIDFloat.o && ./pidtest
+///
+/// The first line builds the reference under another class name, so both
+/// versions can run side by side.  Each run gives both controllers the same
+/// random gains, set point and process values and compares their outputs on
+/// every cycle.  Whole degree inputs must give identical outputs; with a
+/// fraction of a degree, the float sum is rounded to 24 bits and may truncate
+/// to the next output step, so those are allowed to differ by one step.
+///
+/// The timings only show the relative cost on the host, which has a floating
+/// point unit.  On AVR the float version runs in software and the gap is much
+/// wider; time it there with a cycle counting simulator such as simavr.
+
+#ifdef HOST_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Declare the reference under its own name, then the fixed point version
+#define PID FloatPID
+#include "PID.hh"
+#undef PID
+#undef PID_HH_
+#include "PID.hh"
+
+static const int RUNS = 200;
+static const int CYCLES = 5000;
+
+/// Random value in [lo, hi]
+static int randomIn(int lo, int hi) {
+	return lo + rand() % (hi - lo + 1);
+}
+
+/// Run both controllers on the same inputs
+/// \param[in] sixteenths True to feed process values with a fraction
+/// \param[out] far Number of outputs more than one step apart
+/// \return Number of outputs that differ
+static long compare(bool sixteenths, long& far) {
+	long differ = 0;
+	far = 0;
+	for (int run = 0; run < RUNS; run++) {
+		PID fixed;
+		FloatPID reference;
+		// gains small enough that the float output does not need saturating
+		uint16_t p = randomIn(0, 8 * 256);
+		uint16_t i = randomIn(0, 256);
+		uint16_t d = randomIn(0, 16 * 256);
+		fixed.setGainsFixed16(p, i, d);
+		reference.setGainsFixed16(p, i, d);
+		int sp = randomIn(0, 250);
+		fixed.setTarget(sp);
+		reference.setTarget(sp);
+
+		// a noisy first order approach to the set point
+		int pv = randomIn(20, 250) << TEMPERATURE_FRACTION_BITS;
+		for (int cycle = 0; cycle < CYCLES; cycle++) {
+			int target = sp << TEMPERATURE_FRACTION_BITS;
+			pv += (target - pv) / 64 + randomIn(-24, 24);
+			int input = sixteenths ? pv : (pv >> TEMPERATURE_FRACTION_BITS) << TEMPERATURE_FRACTION_BITS;
+			int out = fixed.calculateSixteenths(input);
+			int ref = reference.calculateSixteenths(input);
+			if (out != ref) {
+				differ++;
+				if (abs(out - ref) > 2) {
+					far++;
+				}
+			}
+		}
+	}
+	return differ;
+}
+
+/// Time a controller
+/// \return Nanoseconds per cycle
+template<typename C>
+static double timeCycles() {
+	C pid;
+	pid.setGainsFixed16(PID_FIXED16(7.0), PID_FIXED16(0.325), PID_FIXED16(36.0));
+	pid.setTarget(230);
+	const long count = 10000000L;
+	volatile int sink = 0;
+	clock_t start = clock();
+	for (long n = 0; n < count; n++) {
+		sink += pid.calculateSixteenths(3600 + (int)(n & 63));
+	}
+	return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / count;
+}
+
+int main() {
+	srand(1);
+	long errors = 0;
+	long far;
+
+	long whole = compare(false, far);
+	printf("whole degrees: %ld of %ld outputs differ\n", whole, (long)RUNS * CYCLES);
+	errors += whole;
+
+	long fraction = compare(true, far);
+	printf("sixteenths:    %ld of %ld outputs differ by one step, %ld by more\n",
+	       fraction - far, (long)RUNS * CYCLES, far);
+	errors += far;
+
+	printf("fixed point    %6.2f ns/cycle\n", timeCycles<PID>());
+	printf("float          %6.2f ns/cycle\n", timeCycles<FloatPID>());
+	printf("%s\n", errors ? "FAIL" : "PASS");
+	return errors ? 1 : 0;
+}
+
+#endif // HOST_TEST
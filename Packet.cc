@@ -18,10 +18,29 @@
 #include "Packet.hh"
 #include <util/crc16.h>
 
+#ifdef SLAVE_BUS_FEC
+/// Compute the contribution of one payload byte to the error correction
+/// syndrome.  Bits are numbered from 1 so that a syndrome difference of
+/// zero means no payload bit has changed.
+static uint16_t fecSyndrome(uint8_t index, uint8_t data) {
+	uint16_t syndrome = 0;
+	uint16_t position = ((uint16_t)index << 3) + 1;
+	for (; data != 0; data >>= 1, position++) {
+		if (data & 0x01) {
+			syndrome ^= position;
+		}
+	}
+	return syndrome;
+}
+#endif
+
 /// Append a byte and update the CRC
 void Packet::appendByte(uint8_t data) {
 	if (length < MAX_PACKET_PAYLOAD) {
 		crc = _crc_ibutton_update(crc, data);
+#ifdef SLAVE_BUS_FEC
+		fec_syndrome ^= fecSyndrome(length, data);
+#endif
 		payload[length] = data;
 		length++;
 	}
@@ -30,6 +49,9 @@ void Packet::appendByte(uint8_t data) {
 void Packet::reset() {
 	crc = 0;
 	length = 0;
+#ifdef SLAVE_BUS_FEC
+	fec_syndrome = 0;
+#endif
 #ifdef PARANOID
 	for (uint8_t i = 0; i < MAX_PACKET_PAYLOAD; i++) {
 		payload[i] = 0;
@@ -40,6 +62,10 @@ void Packet::reset() {
 }
 
 InPacket::InPacket() {
+#ifdef SLAVE_BUS_FEC
+	fec_enabled = false;
+	fec_corrected = 0;
+#endif
 	reset();
 }
 
@@ -69,14 +95,57 @@ void InPacket::processByte(uint8_t b) {
 			state = PS_CRC;
 		}
 	} else if (state == PS_CRC) {
+#ifdef SLAVE_BUS_FEC
+		if (fec_enabled) {
+			received_crc = b;
+			state = PS_FEC_LOW;
+			return;
+		}
+#endif
 		if (crc == b) {
 			state = PS_LAST;
 		} else {
 			error(PacketError::BAD_CRC);
 		}
 	}
+#ifdef SLAVE_BUS_FEC
+	else if (state == PS_FEC_LOW) {
+		received_syndrome = b;
+		state = PS_FEC_HIGH;
+	} else if (state == PS_FEC_HIGH) {
+		received_syndrome |= (uint16_t)b << 8;
+		if (crc == received_crc) {
+			// A damaged trailer on an intact payload is harmless
+			state = PS_LAST;
+		} else if (correctSingleBitError()) {
+			fec_corrected++;
+			state = PS_LAST;
+		} else {
+			error(PacketError::BAD_CRC);
+		}
+	}
+#endif
 }
 
+#ifdef SLAVE_BUS_FEC
+bool InPacket::correctSingleBitError() {
+	uint16_t position = fec_syndrome ^ received_syndrome;
+	if (position == 0 || position > ((uint16_t)length << 3)) {
+		return false;
+	}
+	position--;
+	payload[position >> 3] ^= (uint8_t)(1 << (position & 0x07));
+
+	// Double errors can produce a plausible syndrome, so only accept the
+	// repair if the CRC agrees with it.
+	uint8_t check = 0;
+	for (uint8_t i = 0; i < length; i++) {
+		check = _crc_ibutton_update(check, payload[i]);
+	}
+	return check == received_crc;
+}
+#endif
+
 // Reads an 8-bit byte from the specified index of the payload
 uint8_t Packet::read8(uint8_t index) const {
 	return payload[index];
@@ -101,6 +170,9 @@ uint32_t Packet::read32(uint8_t index) const {
 }
 
 OutPacket::OutPacket() {
+#ifdef SLAVE_BUS_FEC
+	fec_enabled = false;
+#endif
 	reset();
 }
 
@@ -131,6 +203,17 @@ uint8_t OutPacket::getNextByteToSend() {
 	} else if (state == PS_CRC) {
 		next_byte = crc;
 		state = PS_LAST;
+#ifdef SLAVE_BUS_FEC
+		if (fec_enabled) {
+			state = PS_FEC_LOW;
+		}
+	} else if (state == PS_FEC_LOW) {
+		next_byte = fec_syndrome & 0xff;
+		state = PS_FEC_HIGH;
+	} else if (state == PS_FEC_HIGH) {
+		next_byte = (fec_syndrome >> 8) & 0xff;
+		state = PS_LAST;
+#endif
 	}
 	return next_byte;
 }
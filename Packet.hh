@@ -70,6 +70,10 @@ protected:
 		PS_LEN,
 		PS_PAYLOAD,
 		PS_CRC,
+#ifdef SLAVE_BUS_FEC
+		PS_FEC_LOW,
+		PS_FEC_HIGH,
+#endif
 		PS_LAST
 	} PacketState;
 
@@ -79,6 +83,11 @@ protected:
 	volatile uint8_t error_code; // Have any errors cropped up during processing?
 	volatile PacketState state;
 
+#ifdef SLAVE_BUS_FEC
+	bool fec_enabled; /// True if this packet carries the error correction trailer after the CRC
+	volatile uint16_t fec_syndrome; /// XOR of the (1-based) bit positions of every set payload bit
+#endif
+
 
 	/// Append a byte and update the CRC
 	void appendByte(uint8_t data);
@@ -106,12 +115,28 @@ public:
 	uint8_t debugGetState() const { return state; }
 
 	const volatile uint8_t* getData() const { return payload; }
+
+#ifdef SLAVE_BUS_FEC
+	/// Enable or disable the error correction trailer.  Both ends of a link
+	/// must agree; this is set up by the UART for the RS485 slave bus.
+	void setFec(bool enabled) { fec_enabled = enabled; }
+#endif
 };
 
 /// Input Packet.
 class InPacket: public Packet {
 private:
 	volatile uint8_t expected_length;
+#ifdef SLAVE_BUS_FEC
+	volatile uint8_t received_crc; /// CRC byte as received, kept until the trailer arrives
+	volatile uint16_t received_syndrome; /// Error correction trailer as received
+	uint16_t fec_corrected; /// Number of packets repaired by error correction
+
+	/// Use the syndrome to flip a single damaged payload bit, then check the
+	/// repaired payload against the received CRC.
+	/// \return True if the payload was repaired
+	bool correctSingleBitError();
+#endif
 public:
 	InPacket();
 
@@ -135,6 +160,12 @@ public:
 	void timeout() {
 		error(PacketError::PACKET_TIMEOUT);
 	}
+
+#ifdef SLAVE_BUS_FEC
+	/// Get the number of packets that failed the CRC check but were repaired
+	/// by error correction.  This is not cleared by #reset().
+	uint16_t getCorrectedCount() const { return fec_corrected; }
+#endif
 };
 
 /// Output Packet.
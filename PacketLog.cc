@@ -0,0 +1,136 @@
+#include "PacketLog.hh"
+#include "CircularBuffer.hh"
+#include "Configuration.hh"
+#include <util/atomic.h>
+
+#ifdef PACKET_LOG
+
+#ifndef IS_EXTRUDER_BOARD
+	#include <avr/wdt.h>
+	#include "SDCard.hh"
+#endif
+
+#if defined IS_EXTRUDER_BOARD
+    #include "ExtruderBoard.hh"
+
+	inline micros_t getMicros() { return ExtruderBoard::getBoard().getCurrentMicros(); }
+#else
+    #include "Motherboard.hh"
+
+    inline micros_t getMicros() { return Motherboard::getBoard().getCurrentMicros(); }
+#endif
+
+namespace packetlog {
+
+DEFINE_BUFFER(log, uint8_t, PACKET_LOG_SIZE);
+
+volatile bool running = false;
+uint16_t dropped = 0;
+volatile uint16_t lost_bytes = 0;
+
+void start() {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		log.reset();
+		dropped = 0;
+		lost_bytes = 0;
+		running = true;
+	}
+}
+
+void stop() {
+	running = false;
+}
+
+bool isRunning() {
+	return running;
+}
+
+void record(const InPacket& packet) {
+	if (!running) {
+		return;
+	}
+
+	uint8_t length = packet.getLength();
+	BufSizeType needed = PACKET_LOG_HEADER_SIZE + length;
+
+	// Discard the oldest records until the new one fits
+	while (log.getRemainingCapacity() < needed) {
+		log.pop(PACKET_LOG_HEADER_SIZE + log[0]);
+		dropped++;
+	}
+
+	micros_t stamp = getMicros();
+	log.push(length);
+	log.push(stamp & 0xff);
+	log.push((stamp >> 8) & 0xff);
+	log.push((stamp >> 16) & 0xff);
+	log.push((stamp >> 24) & 0xff);
+	for (uint8_t i = 0; i < length; i++) {
+		log.push(packet.read8(i));
+	}
+}
+
+uint8_t read(OutPacket& out, uint8_t max_bytes) {
+	uint8_t count = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		running = false;
+		while (count < max_bytes && !log.isEmpty()) {
+			out.append8(log.pop());
+			count++;
+		}
+	}
+	return count;
+}
+
+uint16_t getLength() {
+	uint16_t length;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		length = log.getLength();
+	}
+	return length;
+}
+
+uint16_t getDroppedCount() {
+	return dropped;
+}
+
+void countLostByte() {
+	if (running) {
+		lost_bytes++;
+	}
+}
+
+uint16_t getLostByteCount() {
+	uint16_t count;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		count = lost_bytes;
+	}
+	return count;
+}
+
+#ifndef IS_EXTRUDER_BOARD
+
+bool saveToSDFile(const prog_char *filename) {
+	char fname[16];
+
+	running = false;
+
+	strlcpy_P(fname, filename, sizeof(fname));
+	if ( sdcard::startCapture(fname) != sdcard::SD_SUCCESS )	return false;
+
+	// Recording is stopped, so the interrupt no longer touches the log
+	while (!log.isEmpty()) {
+		sdcard::writeByte(log.pop());
+		wdt_reset();
+	}
+
+	sdcard::finishCapture();
+
+	return true;
+}
+
+#endif
+
+} // namespace packetlog
+
+#endif // PACKET_LOG
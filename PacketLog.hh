@@ -0,0 +1,81 @@
+#ifndef PACKET_LOG_HH_
+#define PACKET_LOG_HH_
+
+#include <stdint.h>
+#include "Packet.hh"
+#include "Types.hh"
+
+#ifndef SIMULATOR
+#include <avr/pgmspace.h>
+#include "Configuration.hh"
+#endif
+
+/// Size of the packet log, in bytes
+#ifndef PACKET_LOG_SIZE
+#define PACKET_LOG_SIZE 512
+#endif
+
+/// Number of header bytes stored before each logged payload
+#define PACKET_LOG_HEADER_SIZE 5
+
+/// The packet log is a flight recorder for host traffic.  While it is running,
+/// every packet completed by the host UART is stored as a record:
+///
+///   uint8  payload length
+///   uint32 time the packet completed, from getCurrentMicros()
+///   payload bytes
+///
+/// When the log is full the oldest records are discarded, so it always holds
+/// the most recent traffic.  Reading the log stops the capture, so that the
+/// records are not overwritten while they are dumped.
+///
+/// The log is only compiled in when PACKET_LOG is defined.
+namespace packetlog {
+
+/// Clear the log and begin recording host packets
+void start();
+
+/// Stop recording; the log contents are kept
+void stop();
+
+/// \return True if host packets are being recorded
+bool isRunning();
+
+/// Append a completed packet to the log.  Called from the host UART receive
+/// interrupt, and does nothing unless the log is running.
+/// \param[in] packet Packet that has just been completed
+void record(const InPacket& packet);
+
+/// Remove up to max_bytes from the head of the log and append them to a
+/// response packet.  Stops the capture.
+/// \param[out] out Packet to append the log bytes to
+/// \param[in] max_bytes Maximum number of bytes to move
+/// \return Number of bytes appended
+uint8_t read(OutPacket& out, uint8_t max_bytes);
+
+/// \return Number of bytes waiting in the log
+uint16_t getLength();
+
+/// \return Number of records discarded to make room for newer ones
+uint16_t getDroppedCount();
+
+/// Count a host byte lost before it reached the packet layer, because the
+/// host UART queue was full.  Called from the host UART receive interrupt
+/// when HOST_FLOW_CONTROL is enabled, and counts only while the log is
+/// running.  The packet the byte belonged to fails its CRC and is never
+/// recorded, so a replay of the log cannot show it.
+void countLostByte();
+
+/// \return Number of host bytes lost since the log was started
+uint16_t getLostByteCount();
+
+#ifndef IS_EXTRUDER_BOARD
+/// Stop the capture and write the log to a file on the SD card, emptying it.
+/// \param[in] filename Name of the file to write, in program memory
+/// \return True if the file was written
+bool saveToSDFile(const prog_char *filename);
+#endif
+
+}
+
+#endif // PACKET_LOG_HH_
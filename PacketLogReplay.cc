@@ -0,0 +1,205 @@
+/// Host tool that replays a #packetlog capture.  It is not part of the
+/// firmware; build and run it on a Linux or macOS host with:
+///
+///     g++ -O2 -DHOST_TEST -o logreplay PacketLogReplay.cc
+///     ./logreplay capture.bin                       # list the records
+///     ./logreplay capture.bin /dev/ttyACM0 115200   # replay them to a board
+///
+/// The capture is the log as written by packetlog::saveToSDFile(), or the
+/// bytes read back with #HOST_CMD_PACKET_LOG, in the record format given in
+/// PacketLog.hh.  Replaying sends each payload to the board as a packet,
+/// spaced as the original traffic was, and waits for each response before
+/// sending the next, so the board sees the production command stream at no
+/// more than its original rate.  Records the board does not answer within a
+/// second are counted as lost.
+
+#ifdef HOST_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+#include <sys/time.h>
+
+static const uint8_t START_BYTE = 0xD5;
+static const uint8_t MAX_PAYLOAD = 32;
+static const uint8_t HEADER_SIZE = 5;
+
+/// The packet CRC, as _crc_ibutton_update() in avr-libc
+static uint8_t crcUpdate(uint8_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 1) ? (crc >> 1) ^ 0x8C : (crc >> 1);
+	}
+	return crc;
+}
+
+static uint32_t nowMicros() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint32_t)(tv.tv_sec * 1000000ULL + tv.tv_usec);
+}
+
+static speed_t baudConstant(long baud) {
+	switch (baud) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+	default: return 0;
+	}
+}
+
+static int openPort(const char* path, long baud) {
+	int fd = open(path, O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	struct termios tio;
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, baudConstant(baud));
+	cfsetospeed(&tio, baudConstant(baud));
+	tio.c_cflag |= CLOCAL | CREAD;
+	tcsetattr(fd, TCSANOW, &tio);
+	tcflush(fd, TCIOFLUSH);
+	return fd;
+}
+
+/// Read one byte, waiting up to a second
+static bool readByte(int fd, uint8_t& b) {
+	struct pollfd p = { fd, POLLIN, 0 };
+	if (poll(&p, 1, 1000) <= 0) {
+		return false;
+	}
+	return read(fd, &b, 1) == 1;
+}
+
+/// Wait for a response packet and check its CRC
+/// \param[out] code First payload byte, the response code
+/// \return True if a good response arrived
+static bool readResponse(int fd, uint8_t& code) {
+	uint8_t b;
+	do {
+		if (!readByte(fd, b)) {
+			return false;
+		}
+	} while (b != START_BYTE);
+	uint8_t length;
+	if (!readByte(fd, length) || length == 0 || length > MAX_PAYLOAD) {
+		return false;
+	}
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < length; i++) {
+		if (!readByte(fd, b)) {
+			return false;
+		}
+		if (i == 0) {
+			code = b;
+		}
+		crc = crcUpdate(crc, b);
+	}
+	return readByte(fd, b) && b == crc;
+}
+
+/// Frame a payload and send it
+static bool sendPacket(int fd, const uint8_t* payload, uint8_t length) {
+	uint8_t packet[MAX_PAYLOAD + 3];
+	uint8_t crc = 0;
+	packet[0] = START_BYTE;
+	packet[1] = length;
+	for (uint8_t i = 0; i < length; i++) {
+		packet[2 + i] = payload[i];
+		crc = crcUpdate(crc, payload[i]);
+	}
+	packet[2 + length] = crc;
+	return write(fd, packet, length + 3) == length + 3;
+}
+
+int main(int argc, char** argv) {
+	if (argc != 2 && !(argc == 4 && baudConstant(atol(argv[3])) != 0)) {
+		fprintf(stderr, "usage: %s capture [port baud]\n", argv[0]);
+		return 2;
+	}
+	FILE* capture = fopen(argv[1], "rb");
+	if (!capture) {
+		perror(argv[1]);
+		return 1;
+	}
+	int fd = -1;
+	if (argc == 4) {
+		fd = openPort(argv[2], atol(argv[3]));
+		if (fd < 0) {
+			return 1;
+		}
+	}
+
+	uint32_t records = 0, lost = 0, errors = 0;
+	uint32_t first_stamp = 0, last_stamp = 0;
+	uint32_t replay_start = nowMicros();
+	uint8_t header[HEADER_SIZE];
+	while (fread(header, 1, HEADER_SIZE, capture) == HEADER_SIZE) {
+		uint8_t length = header[0];
+		uint32_t stamp = header[1] | (header[2] << 8) | (header[3] << 16) | ((uint32_t)header[4] << 24);
+		uint8_t payload[256];
+		if (length > MAX_PAYLOAD || fread(payload, 1, length, capture) != length) {
+			fprintf(stderr, "record %lu is truncated or corrupt\n", (unsigned long)records);
+			errors++;
+			break;
+		}
+		if (records == 0) {
+			first_stamp = stamp;
+		}
+		// the board clock is 32 bits, so differences stay right across a wrap
+		uint32_t offset = stamp - first_stamp;
+		if (records > 0 && stamp - last_stamp > 0x80000000UL) {
+			fprintf(stderr, "record %lu goes back in time\n", (unsigned long)records);
+		}
+		last_stamp = stamp;
+		records++;
+
+		if (fd < 0) {
+			printf("%10.6f  %2u:", offset * 1e-6, length);
+			for (uint8_t i = 0; i < length; i++) {
+				printf(" %02x", payload[i]);
+			}
+			printf("\n");
+			continue;
+		}
+
+		// hold back until the record's time in the original traffic
+		while (nowMicros() - replay_start < offset) {
+			usleep(100);
+		}
+		uint8_t code = 0;
+		if (!sendPacket(fd, payload, length)) {
+			perror("write");
+			return 1;
+		}
+		if (!readResponse(fd, code)) {
+			lost++;
+			tcflush(fd, TCIFLUSH);
+		} else if (code != 0x81) {
+			printf("record %lu, command 0x%02x: response code 0x%02x\n", (unsigned long)records,
+			       length ? payload[0] : 0, code);
+		}
+	}
+	fclose(capture);
+
+	printf("%lu records over %.3f s", (unsigned long)records, (last_stamp - first_stamp) * 1e-6);
+	if (fd >= 0) {
+		printf(", replayed in %.3f s, %lu without a response",
+		       (nowMicros() - replay_start) * 1e-6, (unsigned long)lost);
+		close(fd);
+	}
+	printf("\n");
+	return (errors || lost) ? 1 : 0;
+}
+
+#endif // HOST_TEST
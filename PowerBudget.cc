@@ -0,0 +1,102 @@
+#include "PowerBudget.hh"
+#include "Configuration.hh"
+
+#ifdef HEATER_POWER_BUDGET
+
+namespace powerbudget {
+
+/// A heating element sharing the budget.  Power is kept in watt-duty units
+/// (watts * duty) to avoid dividing by 255.
+struct Consumer {
+	uint16_t watts;         ///< Power at full duty
+	uint8_t requested;      ///< Duty last asked for
+	uint8_t applied;        ///< Duty last granted
+	uint16_t eta;           ///< Estimated seconds to target; 0 when holding
+};
+
+Consumer consumers[MAX_CONSUMERS];
+uint8_t consumer_count = 0;
+uint32_t budget = (uint32_t)HEATER_POWER_BUDGET * 255;
+
+void setBudget(uint16_t watts) {
+	budget = (uint32_t)watts * 255;
+}
+
+uint8_t add(uint16_t watts) {
+	if (consumer_count >= MAX_CONSUMERS) {
+		return NO_SLOT;
+	}
+	Consumer& c = consumers[consumer_count];
+	c.watts = watts;
+	c.requested = 0;
+	c.applied = 0;
+	c.eta = 0;
+	return consumer_count++;
+}
+
+/// True if consumer a is served before consumer b
+static bool before(const Consumer& a, uint8_t ai, const Consumer& b, uint8_t bi) {
+	if (a.eta == 0 || b.eta == 0) {
+		if (a.eta != b.eta) {
+			return a.eta == 0;
+		}
+	} else if (a.eta != b.eta) {
+		return a.eta > b.eta;
+	}
+	return ai < bi;
+}
+
+/// Clamp a power to a duty cycle for a consumer
+static uint8_t toDuty(const Consumer& c, uint32_t power) {
+	if (c.watts == 0) {
+		return 255;
+	}
+	uint32_t duty = power / c.watts;
+	return (duty > 255) ? 255 : (uint8_t)duty;
+}
+
+uint8_t request(uint8_t slot, uint8_t duty, uint16_t eta) {
+	if (slot >= consumer_count) {
+		return duty;
+	}
+	Consumer& self = consumers[slot];
+	self.requested = duty;
+	self.eta = eta;
+	if (budget == 0) {
+		self.applied = duty;
+		return duty;
+	}
+
+	// Power wanted by the consumers served before this one, and power
+	// currently drawn by all the others
+	uint32_t ahead = 0;
+	uint32_t others = 0;
+	for (uint8_t i = 0; i < consumer_count; i++) {
+		if (i == slot) {
+			continue;
+		}
+		const Consumer& c = consumers[i];
+		others += (uint32_t)c.watts * c.applied;
+		if (before(c, i, self, slot)) {
+			ahead += (uint32_t)c.watts * c.requested;
+		}
+	}
+
+	// Our share of the budget, limited to what is actually free right now
+	uint32_t share = (ahead < budget) ? budget - ahead : 0;
+	uint32_t available = (others < budget) ? budget - others : 0;
+	if (available < share) {
+		share = available;
+	}
+
+	uint8_t granted = toDuty(self, share);
+	if (granted > duty) {
+		granted = duty;
+	}
+	self.applied = granted;
+	return granted;
+}
+
+} // namespace powerbudget
+
+#endif // HEATER_POWER_BUDGET
@@ -0,0 +1,51 @@
+#ifndef POWER_BUDGET_HH_
+#define POWER_BUDGET_HH_
+
+#include <stdint.h>
+
+/// The power budget shares a limited supply between heating elements, so that
+/// the #PSU does not have to be sized for every element at full power at
+/// once.  Each heater registers its element's rated wattage, and asks for a
+/// duty cycle every time it sets its output.  The grants are sized so that the
+/// total draw stays within the budget:
+///
+/// - heaters holding their temperature are served first, since they need
+///   little power and must not sag;
+/// - heaters that are heating up are then served in order of their estimated
+///   time to target, longest first, so the slowest heater (usually the
+///   platform) is never held back, and faster ones are slowed until they are
+///   due to finish together with it.
+///
+/// A heater's grant may also be cut because the others have not yet released
+/// power they no longer need; it catches up on its next update.
+///
+/// The budget is only compiled in when HEATER_POWER_BUDGET is defined, as the
+/// supply's rating in watts.
+namespace powerbudget {
+
+/// Maximum number of heaters that can share the budget
+const static uint8_t MAX_CONSUMERS = 4;
+
+/// Returned by #add() when the consumer table is full
+const static uint8_t NO_SLOT = 0xff;
+
+/// Set the power available to the heaters
+/// \param[in] watts Supply budget, in watts; 0 for no limit
+void setBudget(uint16_t watts);
+
+/// Register a heating element
+/// \param[in] watts Power the element draws at full duty
+/// \return Slot to pass to #request(), or #NO_SLOT if the table is full
+uint8_t add(uint16_t watts);
+
+/// Ask for a duty cycle
+/// \param[in] slot Slot returned by #add()
+/// \param[in] duty Duty cycle wanted, 0-255
+/// \param[in] eta Estimated seconds until the heater reaches its target;
+///                0 if it is holding temperature or off
+/// \return Duty cycle to apply, 0-255
+uint8_t request(uint8_t slot, uint8_t duty, uint16_t eta);
+
+}
+
+#endif // POWER_BUDGET_HH_
@@ -0,0 +1,59 @@
+#include "Profiler.hh"
+#include "Configuration.hh"
+
+#ifdef PROFILER
+
+#if defined IS_EXTRUDER_BOARD
+    #include "ExtruderBoard.hh"
+
+	inline micros_t getMicros() { return ExtruderBoard::getBoard().getCurrentMicros(); }
+#else
+    #include "Motherboard.hh"
+
+    inline micros_t getMicros() { return Motherboard::getBoard().getCurrentMicros(); }
+#endif
+
+namespace profiler {
+
+SliceStats stats[SLICE_COUNT];
+
+void record(Slice slice, micros_t duration, bool continued) {
+	SliceStats& s = stats[slice];
+	// stop both counts together, so the average doesn't drift
+	if (s.total_micros + duration >= s.total_micros && s.calls != 0xffffffff) {
+		s.total_micros += duration;
+		if (!continued) {
+			s.calls++;
+		}
+	}
+	if (duration > s.max_micros) {
+		s.max_micros = duration;
+	}
+}
+
+const SliceStats& getStats(Slice slice) {
+	return stats[slice];
+}
+
+void reset() {
+	for (uint8_t i = 0; i < SLICE_COUNT; i++) {
+		stats[i].total_micros = 0;
+		stats[i].calls = 0;
+		stats[i].max_micros = 0;
+	}
+}
+
+} // namespace profiler
+
+ProfileScope::ProfileScope(profiler::Slice slice_in, bool continued_in) :
+	slice(slice_in),
+	continued(continued_in),
+	start_micros(getMicros())
+{
+}
+
+ProfileScope::~ProfileScope() {
+	profiler::record(slice, getMicros() - start_micros, continued);
+}
+
+#endif // PROFILER
@@ -0,0 +1,75 @@
+#ifndef PROFILER_HH_
+#define PROFILER_HH_
+
+#include <stdint.h>
+#include "Types.hh"
+
+/// The profiler accounts for where main loop time goes.  Each major slice of
+/// the loop is wrapped in a PROFILE_SLICE(), which times it with the
+/// microsecond clock and adds the result to that slice's totals.  The totals
+/// can be read by the host with HOST_CMD_GET_PROFILE, and are shown on the
+/// BotStats screen.
+///
+/// The profiler is only compiled in when PROFILER is defined; otherwise
+/// PROFILE_SLICE() expands to nothing.
+namespace profiler {
+
+/// Main loop slices that can be profiled
+enum Slice {
+	SLICE_HOST = 0,         ///< Host packet handling
+	SLICE_COMMAND = 1,      ///< Command queue processing
+	SLICE_INTERFACE = 2,    ///< Button handling and LCD updates
+	SLICE_HEATERS = 3,      ///< Temperature sensing and heater control
+	SLICE_SD = 4,           ///< SD card access
+	SLICE_COUNT = 5
+};
+
+/// Accumulated timing for one slice.  Once either count saturates, both stop,
+/// so the average of the two stays right.
+struct SliceStats {
+	micros_t total_micros;  ///< Total time spent in the slice
+	uint32_t calls;         ///< Number of times the slice ran
+	micros_t max_micros;    ///< Longest single stretch of the slice
+};
+
+/// Add the time of a slice to its totals
+/// \param[in] slice Slice that ran
+/// \param[in] duration Length of the run, in microseconds
+/// \param[in] continued True if this continues a run that yielded, which
+///                      adds its time without counting another call
+void record(Slice slice, micros_t duration, bool continued = false);
+
+/// \param[in] slice Slice to read
+/// \return Totals for the slice since the last reset
+const SliceStats& getStats(Slice slice);
+
+/// Clear the totals of every slice
+void reset();
+
+}
+
+/// Times the enclosing scope and records it against a slice when it exits.
+/// Use it through PROFILE_SLICE().
+class ProfileScope {
+private:
+	profiler::Slice slice;
+	bool continued;
+	micros_t start_micros;
+public:
+	ProfileScope(profiler::Slice slice_in, bool continued_in = false);
+	~ProfileScope();
+};
+
+#ifdef PROFILER
+/// Profile the rest of the enclosing scope as the given slice
+#define PROFILE_SLICE(slice) ProfileScope profile_scope_(profiler::slice)
+/// Profile the rest of the enclosing scope as part of a run of the given slice
+/// that is spread over several scopes, such as a #Task body that yields.  Only
+/// the part that starts a run counts as a call.
+#define PROFILE_SLICE_PART(slice, continued) ProfileScope profile_scope_(profiler::slice, continued)
+#else
+#define PROFILE_SLICE(slice)
+#define PROFILE_SLICE_PART(slice, continued)
+#endif
+
+#endif // PROFILER_HH_
@@ -112,6 +112,12 @@
 /// </table>
 /// Command length is implicit in the command structure; no explicit separator is needed.
 ///
+/// When the firmware is built with SLAVE_BUS_FEC, packets on the slave network carry a two byte
+/// error correction trailer (little-endian) after the CRC.  It is the XOR of the positions of every
+/// set payload bit, numbering bit 0 of the first payload byte as 1.  A receiver whose CRC check
+/// fails XORs this with the value it computed itself; the result is the position of a single
+/// flipped payload bit, which is corrected and accepted if the CRC then matches.
+///
 /// <h2>Command structure</h2>
 ///
 /// <h3>Host Commands</h3>
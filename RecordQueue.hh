@@ -0,0 +1,135 @@
+#ifndef SHARED_RECORD_QUEUE_HH_
+#define SHARED_RECORD_QUEUE_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include "CircularBuffer.hh"
+
+/// A queue of variable-length records, such as complete commands, stored in a
+/// circular buffer of N bytes.  Each record is preceded by a one byte length
+/// header, and is never split across the end of the storage: when a record
+/// will not fit before the end, the rest of the storage is skipped (marked
+/// with a zero length header).  Every record can therefore be read in place,
+/// and the queued records can be scanned ahead without decoding them.
+///
+/// Records are 1 to 255 bytes long.  As with #CircularBufferTempl, you must
+/// disable interrupts around accesses to a queue that is updated in an
+/// interrupt.
+template<BufSizeType N>
+class RecordQueue : private StaticCircularBuffer<uint8_t, N> {
+private:
+	typedef StaticCircularBuffer<uint8_t, N> Buffer;
+
+	BufSizeType count; /// Number of records in the queue
+
+	/// Drop the skipped space at the end of the storage if the head has
+	/// reached it
+	inline void skipPadding() {
+		if (!this->isEmpty() && this->data[this->start] == 0) {
+			Buffer::pop(N - this->start);
+		}
+	}
+public:
+	RecordQueue() : count(0) {
+	}
+
+	using Buffer::getLength;
+	using Buffer::getRemainingCapacity;
+	using Buffer::isEmpty;
+	using Buffer::hasOverflow;
+	using Buffer::hasUnderflow;
+
+	/// Reset the queue to its empty state
+	inline void reset() {
+		Buffer::reset();
+		count = 0;
+	}
+
+	/// Get the number of records in the queue
+	inline BufSizeType getRecordCount() const {
+		return count;
+	}
+
+	/// Append a record to the queue.
+	/// \param[in] record Record data
+	/// \param[in] len Record length, 1 to 255 bytes
+	/// \return False if the record did not fit; the overflow flag is set
+	inline bool push_record(const uint8_t* record, uint8_t len) {
+		if (len == 0) {
+			return false;
+		}
+		if (this->isEmpty()) {
+			// Start from the beginning of the storage to avoid padding
+			this->start = 0;
+		}
+		BufSizeType pos = Buffer::wrap(this->start + this->length);
+		BufSizeType pad = (N - pos < (BufSizeType)len + 1) ? N - pos : 0;
+		if (this->getRemainingCapacity() < pad + len + 1) {
+			this->noteOverflow();
+			return false;
+		}
+		if (pad != 0) {
+			this->data[pos] = 0;
+			this->length += pad;
+			pos = 0;
+		}
+		this->data[pos] = len;
+		memcpy(this->data + pos + 1, record, len);
+		this->length += len + 1;
+		this->notePush();
+		count++;
+		return true;
+	}
+
+	/// Get the record at the head of the queue without removing it
+	/// \param[out] len Length of the record
+	/// \return Pointer to the record data, or 0 if the queue is empty
+	inline const uint8_t* front(uint8_t& len) {
+		if (this->isEmpty()) {
+			return 0;
+		}
+		len = this->data[this->start];
+		return this->data + this->start + 1;
+	}
+
+	/// Remove the record at the head of the queue.  Sets the underflow flag
+	/// if the queue is empty.
+	inline void pop_record() {
+		if (this->isEmpty()) {
+			this->noteUnderflow();
+			return;
+		}
+		Buffer::pop(this->data[this->start] + 1);
+		count--;
+		skipPadding();
+	}
+
+	/// Walk the queued records without removing them, for example to look
+	/// ahead at upcoming commands:
+	///
+	///     BufSizeType cursor = 0;
+	///     uint8_t len;
+	///     const uint8_t* record;
+	///     while ((record = queue.peek_record(cursor, len)) != 0) { ... }
+	///
+	/// \param[in,out] cursor 0 to start at the head; advanced past the record
+	///                       that is returned
+	/// \param[out] len Length of the record
+	/// \return Pointer to the record data, or 0 after the last record
+	inline const uint8_t* peek_record(BufSizeType& cursor, uint8_t& len) {
+		while (cursor < this->length) {
+			BufSizeType pos = Buffer::wrap(this->start + cursor);
+			uint8_t header = this->data[pos];
+			if (header == 0) {
+				cursor += N - pos;
+				continue;
+			}
+			len = header;
+			cursor += len + 1;
+			return this->data + pos + 1;
+		}
+		return 0;
+	}
+};
+
+#endif // SHARED_RECORD_QUEUE_HH_
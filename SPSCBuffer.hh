@@ -0,0 +1,130 @@
+#ifndef SHARED_SPSC_BUFFER_HH_
+#define SHARED_SPSC_BUFFER_HH_
+
+#include <stdint.h>
+#include "CircularBuffer.hh"
+
+/// Keep the compiler from moving memory accesses across this point.  A single
+/// AVR core needs no hardware barrier, only a compiler one.  Host builds use
+/// acquire and release atomics instead (see SPSCBuffer::acquire()).
+#define SPSC_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+/// A circular buffer for handing data from exactly one producer to exactly one
+/// consumer, for instance from an interrupt to the main loop, without
+/// disabling interrupts.  The producer only writes the head index and the
+/// consumer only writes the tail index, so each side sees the other's index
+/// either before or after an update, never half way.
+///
+/// That relies on index loads and stores being atomic, which on AVR is only
+/// true of single bytes, hence the default uint8_t index type and a maximum
+/// size of 128 entries.  A wider index type is only safe on processors that
+/// access it atomically.  The size must be a power of two.
+///
+/// Methods are split by the side that may call them: push() and
+/// getRemainingCapacity() belong to the producer, pop(), peek() and
+/// getLength() to the consumer.
+template<typename T, BufSizeType N, typename IndexType = uint8_t>
+class SPSCBuffer {
+public:
+	typedef T BufDataType;
+private:
+	typedef char size_must_be_a_power_of_two[(N & (N - 1)) == 0 ? 1 : -1];
+	typedef char size_must_fit_the_index[(N - 1) <= (IndexType)(~(IndexType)0) / 2 ? 1 : -1];
+
+	BufDataType data[N]; /// Buffer data
+	volatile IndexType head; /// Free-running count of pushed entries, written by the producer
+	volatile IndexType tail; /// Free-running count of popped entries, written by the consumer
+	volatile bool overflow; /// Overflow indicator, written by the producer
+	volatile bool underflow; /// Underflow indicator, written by the consumer
+
+	/// Read the other side's index, ahead of any access to the entries it
+	/// covers
+	static inline IndexType acquire(const volatile IndexType& index) {
+#ifdef HOST_TEST
+		return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+#else
+		IndexType value = index;
+		SPSC_BARRIER();
+		return value;
+#endif
+	}
+
+	/// Publish this side's index, after every access to the entries it covers
+	static inline void release(volatile IndexType& index, IndexType value) {
+#ifdef HOST_TEST
+		__atomic_store_n(&index, value, __ATOMIC_RELEASE);
+#else
+		SPSC_BARRIER();
+		index = value;
+#endif
+	}
+
+public:
+	SPSCBuffer() : head(0), tail(0), overflow(false), underflow(false) {
+	}
+
+	/// Append an entry to the tail of the buffer.  Producer only.
+	/// \return False if the buffer was full and the entry was dropped
+	inline bool push(BufDataType b) {
+		IndexType h = head;
+		// The consumer must have finished reading a slot before it is reused
+		if ((IndexType)(h - acquire(tail)) >= N) {
+			overflow = true;
+			return false;
+		}
+		data[h & (N - 1)] = b;
+		// The entry must be stored before the consumer can see it
+		release(head, h + 1);
+		return true;
+	}
+
+	/// Pop an entry off the head of the buffer.  Consumer only.
+	inline BufDataType pop() {
+		IndexType t = tail;
+		// The entry must not be read before the producer has published it
+		if (t == acquire(head)) {
+			underflow = true;
+			return BufDataType();
+		}
+		const BufDataType popped = data[t & (N - 1)];
+		// The entry must be read before the producer can reuse its slot
+		release(tail, t + 1);
+		return popped;
+	}
+
+	/// Read an entry without removing it.  Consumer only.
+	/// \param[in] index Offset from the head of the buffer; must be less than
+	///                  #getLength().
+	inline BufDataType peek(IndexType index) const {
+		// As in pop(), order the read after the producer's publication
+		acquire(head);
+		return data[(IndexType)(tail + index) & (N - 1)];
+	}
+
+	/// Get the number of entries waiting.  Exact for the consumer; the
+	/// producer may add entries at any time.
+	inline BufSizeType getLength() const {
+		return (IndexType)(head - tail);
+	}
+
+	/// Get the remaining capacity of this buffer.  Exact for the producer;
+	/// the consumer may free entries at any time.
+	inline BufSizeType getRemainingCapacity() const {
+		return N - (IndexType)(head - tail);
+	}
+
+	/// Check if the buffer is empty
+	inline bool isEmpty() const {
+		return head == tail;
+	}
+	/// Check the overflow flag
+	inline bool hasOverflow() const {
+		return overflow;
+	}
+	/// Check the underflow flag
+	inline bool hasUnderflow() const {
+		return underflow;
+	}
+};
+
+#endif // SHARED_SPSC_BUFFER_HH_
@@ -0,0 +1,81 @@
+/// Host stress test for #SPSCBuffer, with a producer and a consumer thread
+/// standing in for an interrupt and the main loop.  It is not part of the
+/// firmware; build and run it on the host with:
+///
+///     g++ -O2 -DHOST_TEST -pthread -o spscstress SPSCBufferStress.cc && ./spscstress
+///
+/// The producer pushes a counting sequence, retrying whenever the buffer is
+/// full, and the consumer checks that every entry arrives exactly once and in
+/// order.  On AVR the buffer only needs a compiler barrier between the data
+/// and the index; host builds use acquire and release atomics at the same
+/// points, so the test also holds on weakly ordered hosts.  There it checks
+/// that the barriers sit where the data accesses need them: a missing one
+/// shows up as stale or repeated entries.
+
+#ifdef HOST_TEST
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "SPSCBuffer.hh"
+
+static const uint32_t ENTRIES = 20000000UL;
+
+/// Small enough that both the full and empty cases are hit often, with the
+/// default byte index wrapping every 256 entries
+static SPSCBuffer<uint32_t, 16> buffer;
+
+static void* produce(void*) {
+	for (uint32_t i = 0; i < ENTRIES; i++) {
+		while (!buffer.push(i)) {
+			// let the consumer run where the host has a single core
+			sched_yield();
+		}
+	}
+	return 0;
+}
+
+static void* consume(void* errors_out) {
+	uint32_t errors = 0;
+	uint32_t expected = 0;
+	while (expected < ENTRIES) {
+		if (buffer.isEmpty()) {
+			sched_yield();
+			continue;
+		}
+		BufSizeType length = buffer.getLength();
+		if (length == 0 || length > 16) {
+			errors++;
+		}
+		if (buffer.peek(0) != expected) {
+			errors++;
+		}
+		if (buffer.pop() != expected) {
+			errors++;
+		}
+		expected++;
+	}
+	*(uint32_t*)errors_out = errors;
+	return 0;
+}
+
+int main() {
+	uint32_t errors = 0;
+	pthread_t producer, consumer;
+	pthread_create(&consumer, 0, consume, &errors);
+	pthread_create(&producer, 0, produce, 0);
+	pthread_join(producer, 0);
+	pthread_join(consumer, 0);
+
+	// the consumer never pops an empty buffer, so underflow must be clear;
+	// overflow is expected, as the producer retries a full buffer
+	if (buffer.hasUnderflow() || !buffer.isEmpty()) {
+		errors++;
+	}
+	printf("%lu entries, overflow %s\n", (unsigned long)ENTRIES,
+	       buffer.hasOverflow() ? "seen" : "not seen");
+	printf("%s (%lu errors)\n", errors ? "FAIL" : "PASS", (unsigned long)errors);
+	return errors ? 1 : 0;
+}
+
+#endif // HOST_TEST
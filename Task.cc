@@ -0,0 +1,82 @@
+#include "Task.hh"
+#include "TimerQueue.hh"
+#include "Configuration.hh"
+
+#if defined IS_EXTRUDER_BOARD
+    #include "ExtruderBoard.hh"
+
+	inline micros_t getMicros() { return ExtruderBoard::getBoard().getCurrentMicros(); }
+#else
+    #include "Motherboard.hh"
+
+    inline micros_t getMicros() { return Motherboard::getBoard().getCurrentMicros(); }
+#endif
+
+namespace tasks {
+
+Task* task_list[MAX_TASKS];
+uint8_t task_count = 0;
+
+bool add(Task& task) {
+	if (task_count >= MAX_TASKS) {
+		return false;
+	}
+	task.next_run = getMicros();
+	task.resuming = false;
+	task.worst_runtime = 0;
+	task.overruns = 0;
+	task_list[task_count++] = &task;
+	return true;
+}
+
+void runSlice() {
+#ifdef TIMER_QUEUE
+	// Expire the due timeouts first, so the tasks see them this pass
+	timerqueue::run();
+#endif
+
+	micros_t now = getMicros();
+
+	// Pick the highest priority task that is due or part way through a run
+	Task* next = 0;
+	for (uint8_t i = 0; i < task_count; i++) {
+		Task* task = task_list[i];
+		if (task->resuming || (int32_t)(now - task->next_run) >= 0) {
+			if (next == 0 || task->priority > next->priority) {
+				next = task;
+			}
+		}
+	}
+	if (next == 0) {
+		return;
+	}
+
+	bool finished = next->run();
+	micros_t end = getMicros();
+
+	micros_t runtime = end - now;
+	if (runtime > next->worst_runtime) {
+		next->worst_runtime = runtime;
+	}
+	if (runtime > next->budget && next->overruns != 0xffff) {
+		next->overruns++;
+	}
+
+	next->resuming = !finished;
+	if (finished) {
+		next->next_run += next->period;
+		// Don't try to catch up on runs missed while the loop was busy
+		if ((int32_t)(end - next->next_run) >= 0) {
+			next->next_run = end + next->period;
+		}
+	}
+}
+
+void resetStats() {
+	for (uint8_t i = 0; i < task_count; i++) {
+		task_list[i]->worst_runtime = 0;
+		task_list[i]->overruns = 0;
+	}
+}
+
+} // namespace tasks
@@ -0,0 +1,79 @@
+#ifndef TASK_HH_
+#define TASK_HH_
+
+#include <stdint.h>
+#include "Types.hh"
+
+/// \defgroup Tasks Cooperative tasks
+/// Main loop work (heater control, packet service, the LCD) can be split into
+/// tasks that the #tasks scheduler runs by period and priority.  Each call to
+/// tasks::runSlice() runs only the most urgent due task, so a high priority
+/// task never waits for more than one slice of a lower priority one.  Long
+/// tasks should break themselves into short slices using the TASK_ macros
+/// below, which implement stackless coroutines in the style of protothreads:
+///
+///     bool runTask() {
+///         TASK_BEGIN(task_state);
+///         doFirstHalf();
+///         TASK_YIELD(task_state);
+///         doSecondHalf();
+///         TASK_END(task_state);
+///     }
+///
+/// Local variables do not survive a yield; keep anything that must in members.
+/// A TASK_YIELD must not be placed inside a switch statement of its own.
+
+/// Type used to store the resume point of a task
+typedef uint16_t task_state_t;
+
+/// Start the body of a task function.
+#define TASK_BEGIN(state) switch (state) { case 0:
+
+/// Return from the task, resuming after this point when it is next run.
+#define TASK_YIELD(state) do { state = __LINE__; return false; case __LINE__:; } while (0)
+
+/// End the body of a task function; the next run starts from the top.
+#define TASK_END(state) } state = 0; return true
+
+/// A task registered with the #tasks scheduler.  The board owns the task
+/// objects and fills in the first four fields; the rest belong to the
+/// scheduler.
+/// \ingroup Tasks
+struct Task {
+	/// Task body.  Returns true when it has finished its work for this
+	/// period, or false if it yielded and wants to continue as soon as
+	/// nothing more urgent is due.
+	bool (*run)();
+	micros_t period;        ///< Interval between the starts of successive runs
+	micros_t budget;        ///< Longest a single slice should take
+	uint8_t priority;       ///< Higher values run first when several tasks are due
+
+	micros_t next_run;      ///< Time the next run is due
+	bool resuming;          ///< True if the task yielded and is part way through a run
+	micros_t worst_runtime; ///< Longest slice seen, in microseconds
+	uint16_t overruns;      ///< Number of slices that took longer than the budget
+};
+
+/// The scheduler for cooperative #Task objects.
+/// \ingroup Tasks
+namespace tasks {
+
+/// Maximum number of tasks that can be registered
+const static uint8_t MAX_TASKS = 8;
+
+/// Register a task.  It becomes due immediately.
+/// \param[in] task Task to run; must stay valid for the life of the program
+/// \return False if the task table is full
+bool add(Task& task);
+
+/// Run a single slice of the most urgent due task, if any.  Call this from the
+/// main loop in place of polling each subsystem.  With TIMER_QUEUE, this also
+/// runs timerqueue::run() first.
+void runSlice();
+
+/// Clear the runtime statistics of every task
+void resetStats();
+
+}
+
+#endif // TASK_HH_
@@ -19,6 +19,7 @@
 #define TEMPERATURE_HH_
 
 #include <stdint.h>
+#include "Types.hh"
 
 /// Flag specifying that the temperature reading is invalid.
 #define BAD_TEMPERATURE 1024
@@ -47,6 +48,15 @@ public:
 	///         last read failed.
 	int16_t getTemperature() const { return current_temp; }
 
+	/// Get the last read temperature, with the resolution the sensor gives.
+	/// \return The current temperature, in sixteenths of a degree Celsius (see
+	///         #TEMPERATURE_FRACTION_BITS); by default the whole degree reading.
+	virtual int16_t getTemperatureSixteenths() const { return current_temp << TEMPERATURE_FRACTION_BITS; }
+
+	/// Get the unconverted value behind the last reading, for diagnostics.
+	/// \return The raw sensor value; by default the temperature itself.
+	virtual int16_t getRawValue() const { return current_temp; }
+
 	/// Initialize the temperature sensor hardware. Must be called before the temperature
 	/// sensor can be used.
 	virtual void init() {}
@@ -16,6 +16,7 @@
  */
 
 #include "TemperatureTable.hh"
+#include "Types.hh"
 #include "Configuration.hh"
 #include "EepromMap.hh"
 #include <avr/eeprom.h>
@@ -161,12 +162,13 @@ inline Entry getEntry(int8_t entryIdx, int8_t table_id) {
 	return rv;
 }
 
-/// Translate a temperature reading into degrees Celcius, using the provided lookup table.
+/// Find the pair of table entries a reading falls between.
 /// @param[in] reading Thermistor/Thermocouple voltage reading, in ADC counts
 /// @param[in] table_idx therm_tables index of the temperature lookup table
-/// @param[in] max_allowed_value default temperature if reading is outside of lookup table
-/// @return Temperature reading, in degrees Celcius
-int16_t TempReadtoCelsius(int16_t reading, int8_t table_idx, int16_t max_allowed_value) {
+/// @param[out] eb Entry at or below the reading
+/// @param[out] et Entry above the reading
+/// @return false if the reading is outside of the lookup table
+static bool findEntries(int16_t reading, int8_t table_idx, Entry& eb, Entry& et) {
 	int8_t bottom = 0;
 	int8_t current_numtemps;
   current_numtemps = NUMTEMPS_ALL[table_idx];
@@ -186,14 +188,27 @@ int16_t TempReadtoCelsius(int16_t reading, int8_t table_idx, int16_t max_allowed
 			mid = (bottom+top)/2;
 		}
 	}
-	Entry eb = getEntry(bottom,table_idx);
-	Entry et = getEntry(top,table_idx);
+	eb = getEntry(bottom,table_idx);
+	et = getEntry(top,table_idx);
 	if (bottom == 0 && reading < eb.adc) {
 		// out of scale; safety mode
-		return max_allowed_value;
+		return false;
 	}
 	if (top == current_numtemps-1 && reading > et.adc) {
 		// out of scale; safety mode
+		return false;
+	}
+	return true;
+}
+
+/// Translate a temperature reading into degrees Celcius, using the provided lookup table.
+/// @param[in] reading Thermistor/Thermocouple voltage reading, in ADC counts
+/// @param[in] table_idx therm_tables index of the temperature lookup table
+/// @param[in] max_allowed_value default temperature if reading is outside of lookup table
+/// @return Temperature reading, in degrees Celcius
+int16_t TempReadtoCelsius(int16_t reading, int8_t table_idx, int16_t max_allowed_value) {
+	Entry eb, et;
+	if (!findEntries(reading, table_idx, eb, et)) {
 		return max_allowed_value;
 	}
 
@@ -205,6 +220,29 @@ int16_t TempReadtoCelsius(int16_t reading, int8_t table_idx, int16_t max_allowed
 	return celsius;
 }
 
+/// Translate a temperature reading into sixteenths of a degree Celsius, using
+/// the provided lookup table.
+/// @param[in] reading Thermistor/Thermocouple voltage reading, in ADC counts
+/// @param[in] table_idx therm_tables index of the temperature lookup table
+/// @param[in] max_allowed_value default temperature if reading is outside of lookup
+///            table, in whole degrees
+/// @return Temperature reading, in sixteenths of a degree Celsius
+int16_t TempReadtoSixteenths(int16_t reading, int8_t table_idx, int16_t max_allowed_value) {
+	int16_t max_sixteenths = max_allowed_value << TEMPERATURE_FRACTION_BITS;
+	Entry eb, et;
+	if (!findEntries(reading, table_idx, eb, et)) {
+		return max_sixteenths;
+	}
+
+	// The product needs more than 16 bits once it carries the fraction
+	int32_t span = (int32_t)(et.value - eb.value) << TEMPERATURE_FRACTION_BITS;
+	int16_t sixteenths = (eb.value << TEMPERATURE_FRACTION_BITS) +
+		  (int16_t)(((int32_t)(reading - eb.adc) * span) / (et.adc - eb.adc));
+	if (sixteenths > max_sixteenths) {
+		sixteenths = max_sixteenths;
+	}
+	return sixteenths;
+}
 }
 
 #endif
@@ -36,6 +36,14 @@ enum therm_tables {
 /// @return Temperature reading, in degrees Celcius
 int16_t TempReadtoCelsius(int16_t reading, int8_t table_idx, int16_t max_allowed_value);
 
+/// Translate a temperature reading into sixteenths of a degree Celsius, keeping
+/// the fraction the interpolation between table entries gives.
+/// @param[in] reading Thermistor/Thermocouple voltage reading, in ADC counts
+/// @param[in] table_idx therm_tables index of the temperature lookup table
+/// @param[in] max_allowed_value Temperature limit, in whole degrees Celsius
+/// @return Temperature reading, in sixteenths of a degree Celsius
+int16_t TempReadtoSixteenths(int16_t reading, int8_t table_idx, int16_t max_allowed_value);
+
 }
 
 typedef struct {
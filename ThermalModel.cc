@@ -0,0 +1,104 @@
+#include "ThermalModel.hh"
+
+/// Rise that marks the sensor responding to the element
+#define RESPONSE_DEGREES 2
+
+/// Rise over which the rate of heating is measured
+#define RATE_STEP 10
+
+/// Only heat-ups starting below this temperature are used to identify the model
+#define AMBIENT_MAX 50
+
+ThermalModel::ThermalModel() {
+	reset();
+}
+
+void ThermalModel::reset() {
+	valid = false;
+	heating = false;
+	identifying = false;
+	dead_time = 0;
+	rate_ticks = 0;
+}
+
+void ThermalModel::startHeatup(int16_t temp) {
+	heating = true;
+	ticks = 0;
+	mark_temp = temp;
+	mark_ticks = 0;
+	rate_ticks = 0;
+
+	identifying = (temp < AMBIENT_MAX);
+	if (identifying) {
+		ambient = temp;
+		first_rate_ticks = 0;
+		// wait for the sensor to respond before timing the rise
+		dead_time = 0;
+	}
+}
+
+void ThermalModel::sample(int16_t temp) {
+	if (!heating || ticks == 0xffff) {
+		return;
+	}
+	ticks++;
+
+	if (identifying && dead_time == 0) {
+		if (temp >= ambient + RESPONSE_DEGREES) {
+			dead_time = ticks;
+			mark_temp = temp;
+			mark_ticks = ticks;
+		}
+		return;
+	}
+
+	if (temp >= mark_temp + RATE_STEP) {
+		rate_ticks = ticks - mark_ticks;
+		rate_mid = mark_temp + (temp - mark_temp) / 2;
+		mark_temp = temp;
+		mark_ticks = ticks;
+		if (identifying && first_rate_ticks == 0) {
+			first_rate_ticks = rate_ticks;
+			first_rate_mid = rate_mid;
+		}
+	}
+}
+
+void ThermalModel::endHeatup(int16_t temp) {
+	if (identifying && dead_time != 0 && first_rate_ticks != 0 &&
+		rate_ticks != 0 && rate_mid > first_rate_mid) {
+		// At full power the time to rise RATE_STEP degrees at x degrees above
+		// ambient is n = capacity * RATE_STEP / (255 - loss * x).  The first rise
+		// (n1 at x1) and the last (n2 at x2) give
+		//   loss = 255 * (n2 - n1) / (n2 * x2 - n1 * x1)
+		// in which the capacity cancels out.
+		int32_t n1x1 = (int32_t)first_rate_ticks * (first_rate_mid - ambient);
+		int32_t n2x2 = (int32_t)rate_ticks * (rate_mid - ambient);
+		if (rate_ticks > first_rate_ticks && n2x2 > n1x1) {
+			uint32_t l = ((uint32_t)255 * 256 * (rate_ticks - first_rate_ticks)) / (uint32_t)(n2x2 - n1x1);
+			loss = (l > 0xffff) ? 0xffff : (uint16_t)l;
+		} else {
+			loss = 0;
+		}
+		valid = true;
+	}
+	heating = false;
+	identifying = false;
+}
+
+uint8_t ThermalModel::getSteadyStateOutput(int16_t target) const {
+	if (!valid || target <= ambient) {
+		return 0;
+	}
+	uint32_t output = ((uint32_t)loss * (target - ambient)) >> 8;
+	return (output > 255) ? 255 : (uint8_t)output;
+}
+
+int16_t ThermalModel::getCoastRise() const {
+	if (!heating || dead_time == 0 || rate_ticks == 0) {
+		return -1;
+	}
+	// degrees per tick times the ticks it takes the sensor to respond,
+	// rounded so a short dead time is not lost
+	return (int16_t)(((uint32_t)dead_time * RATE_STEP + rate_ticks / 2) / rate_ticks);
+}
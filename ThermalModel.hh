@@ -0,0 +1,72 @@
+#ifndef THERMAL_MODEL_HH_
+#define THERMAL_MODEL_HH_
+
+#include <stdint.h>
+
+/// A first order model of a heater: a heat capacity warmed by the element,
+/// losing heat in proportion to its temperature above ambient, and seen by
+/// the sensor after a dead time.  The model identifies itself from full power
+/// heat-ups: a heat-up that starts near ambient measures the dead time, and
+/// the loss coefficient from how much the rate of rise has fallen between the
+/// start and the end.  The capacity only matters for the rate of rise, which
+/// is measured directly, so it is not kept.  All times are counted in PID
+/// ticks, the mean temperatures the heater passes to #sample(), and power in
+/// output units (0-255).
+///
+/// The heater uses the model to feed the steady state output for its target
+/// forward alongside the PID, and to leave full power bypass early enough that
+/// the heat still in flight does not overshoot the target.
+/// \ingroup SoftwareLibraries
+class ThermalModel {
+private:
+    int16_t ambient;            ///< Starting temperature of the identified heat-up
+    uint16_t dead_time;         ///< Ticks from switch-on until the sensor responds
+    uint16_t first_rate_ticks;  ///< Ticks taken to rise the first RATE_STEP degrees
+    int16_t first_rate_mid;     ///< Temperature in the middle of that rise
+    uint16_t loss;              ///< Output needed per degree above ambient, 8.8 fixed point
+    bool valid;                 ///< True once a heat-up has been identified
+
+    bool heating;               ///< True during a full power heat-up
+    bool identifying;           ///< True if the current heat-up started near ambient
+    uint16_t ticks;             ///< Ticks since the heat-up started
+    int16_t mark_temp;          ///< Temperature at the last rate mark
+    uint16_t mark_ticks;        ///< Tick count at the last rate mark
+    uint16_t rate_ticks;        ///< Ticks taken to rise the last RATE_STEP degrees,
+                                ///< or 0 if not yet known
+    int16_t rate_mid;           ///< Temperature in the middle of that rise
+
+public:
+    ThermalModel();
+
+    /// Forget the identified model
+    void reset();
+
+    /// Note the start of a full power heat-up
+    /// \param[in] temp Current temperature
+    void startHeatup(int16_t temp);
+
+    /// Note the end of a full power heat-up, and update the model from it
+    /// \param[in] temp Current temperature
+    void endHeatup(int16_t temp);
+
+    /// Add the temperature of a PID tick.  Call once per tick; only ticks
+    /// during a heat-up are used.
+    /// \param[in] temp Mean temperature over the tick
+    void sample(int16_t temp);
+
+    /// \return True once the model has been identified
+    bool isValid() const { return valid; }
+
+    /// Get the output that would hold the heater at a temperature
+    /// \param[in] target Temperature to hold
+    /// \return Output, or 0 if the model has not been identified
+    uint8_t getSteadyStateOutput(int16_t target) const;
+
+    /// Estimate how far the temperature will keep rising if the element is
+    /// switched off now, from the current rate of rise and the dead time
+    /// \return Rise in whole degrees, rounded, or -1 if it can not be estimated
+    ///         yet.  A rise of 0 is too small to act on.
+    int16_t getCoastRise() const;
+};
+
+#endif // THERMAL_MODEL_HH_
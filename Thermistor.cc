@@ -40,6 +40,7 @@ Thermistor::Thermistor(uint8_t analog_pin_in, uint8_t table_index_in) :
 
 void Thermistor::init() {
   current_temp = 0;
+  temp_sixteenths = 0;
 	initAnalogPin(analog_pin);
 }
 
@@ -77,12 +78,15 @@ Thermistor::SensorState Thermistor::update() {
 	//       for now, since it doesn't work for ABP/HBP thermistors.
 	if ((temp > ADC_RANGE - 2) || (temp < 2)) {
                 current_temp = BAD_TEMPERATURE;	// Set the temperature to 1024 as an error condition
+                temp_sixteenths = BAD_TEMPERATURE << TEMPERATURE_FRACTION_BITS;
 		return SS_ERROR_UNPLUGGED;
 	}
 
 	int16_t avg = cumulative / SAMPLE_COUNT;
 
 	//current_temp = thermistorToCelsius(avg,table_index);
-	current_temp = TemperatureTable::TempReadtoCelsius(temp,table_index, MAX_TEMP);
+	// one lookup gives both; the whole degree reading is rounded to nearest
+	temp_sixteenths = TemperatureTable::TempReadtoSixteenths(temp,table_index, MAX_TEMP);
+	current_temp = (temp_sixteenths + (1 << (TEMPERATURE_FRACTION_BITS - 1))) >> TEMPERATURE_FRACTION_BITS;
 	return SS_OK;
 }
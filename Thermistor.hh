@@ -31,6 +31,7 @@ private:
         uint8_t analog_pin;                 ///< index of analog pin
         volatile int16_t raw_value;         ///< raw storage for asynchronous analog read
         volatile bool raw_valid;            ///< flag to state if raw_value contains valid data
+        volatile int16_t temp_sixteenths;   ///< Last temperature, in sixteenths of a degree
         // TODO: This should come from the ADC!
         const static int ADC_RANGE = 1024;  ///< Maximum ADC value
         const static int MAX_TEMP = 255;
@@ -48,6 +49,12 @@ public:
 	void init();
 
 	SensorState update();
+
+	/// \return The last ADC reading
+	int16_t getRawValue() const { return raw_value; }
+
+	/// \return The last temperature, interpolated to sixteenths of a degree
+	int16_t getTemperatureSixteenths() const { return temp_sixteenths; }
 };
 
 #endif //THERMISTOR_H
@@ -44,6 +44,7 @@ void Thermocouple::init() {
 	so_pin.setDirection(false);
 	
 	current_temp = 0;
+	temp_sixteenths = 0;
 
 //	cs_pin.setValue(true);   // Clock select is active low
 //	sck_pin.setValue(false); // TODO: Is this a good idea?
@@ -63,7 +64,7 @@ Thermocouple::SensorState Thermocouple::update() {
 	for (int i = 0; i < 16; i++) {
 		sck_pin.setValue(true);
 		nop();
-		if (i >= 1 && i < 11) { // data bit... skip LSBs
+		if (i >= 1 && i < 13) { // data bit, in quarter degrees
 			raw = raw << 1;
 			if (so_pin.getValue()) { raw = raw | 0x01; }
 		}
@@ -83,9 +84,12 @@ Thermocouple::SensorState Thermocouple::update() {
 	if (bad_temperature) {
 	  // Set the temperature to 1024 as an error condition
 	  current_temp = BAD_TEMPERATURE;
+	  temp_sixteenths = BAD_TEMPERATURE << TEMPERATURE_FRACTION_BITS;
 	  return SS_ERROR_UNPLUGGED;
 	}
 
-	current_temp = raw;
+	// dropping the two fraction bits gives the whole degrees, as before
+	current_temp = raw >> 2;
+	temp_sixteenths = raw << 2;
 	return SS_OK;
 }
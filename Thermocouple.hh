@@ -29,6 +29,7 @@ private:
         Pin cs_pin;  ///< Chip select pin (output)
         Pin sck_pin; ///< Clock pin (output)
         Pin so_pin;  ///< Data pin (input)
+        volatile int16_t temp_sixteenths;  ///< Last temperature, in sixteenths of a degree
 public:
         /// Create a new thermocouple instance, and attach it to the given pins.
         /// \param [in] cs Chip Select (output).
@@ -39,5 +40,8 @@ public:
 	void init();
 
 	SensorState update();
+
+	/// \return The last temperature, which the sensor gives to a quarter degree
+	int16_t getTemperatureSixteenths() const { return temp_sixteenths; }
 };
 #endif // THERMOCOUPLE_HH_
@@ -16,6 +16,7 @@
  */
 
 #include "Timeout.hh"
+#include "TimerQueue.hh"
 #include "Configuration.hh"
 
 #if defined IS_EXTRUDER_BOARD
@@ -28,18 +29,50 @@
     inline micros_t getMicros() { return Motherboard::getBoard().getCurrentMicros(); }
 #endif
 
-Timeout::Timeout() : active(false), elapsed(false) {}
+Timeout::Timeout() : active(false), elapsed(false)
+#ifdef TIMER_QUEUE
+	, scheduled(false)
+#endif
+{}
 
 void Timeout::start(micros_t duration_micros_in) {
 	active = true;
 	is_paused = false;
 	elapsed = false;
+#ifdef TIMER_QUEUE
+	if (scheduled) {
+		timerqueue::remove(this);
+		scheduled = false;
+	}
+#endif
     start_stamp_micros = getMicros();
 	duration_micros = duration_micros_in;
 	pause_micros = 0;
 }
 
+void Timeout::schedule(micros_t duration_micros_in) {
+	start(duration_micros_in);
+#ifdef TIMER_QUEUE
+	scheduled = timerqueue::add(this);
+#endif
+}
+
+#ifdef TIMER_QUEUE
+void Timeout::expire(micros_t deadline) {
+	// Ignore an entry that came due while the timeout was paused
+	if (scheduled && active && !is_paused && deadline == getDeadline()) {
+		active = false;
+		elapsed = true;
+	}
+}
+#endif
+
 bool Timeout::hasElapsed() {
+#ifdef TIMER_QUEUE
+	if (scheduled) {
+		return elapsed;
+	}
+#endif
 	if (active && !elapsed && !is_paused) {
                 micros_t delta = getMicros() - start_stamp_micros;
 		if (delta >= duration_micros) {
@@ -52,6 +85,12 @@ bool Timeout::hasElapsed() {
 
 void Timeout::abort() {
 	active = false;
+#ifdef TIMER_QUEUE
+	if (scheduled) {
+		timerqueue::remove(this);
+		scheduled = false;
+	}
+#endif
 }
 void Timeout::clear(){
 	elapsed = false;
@@ -67,6 +106,12 @@ void Timeout::pause(bool pause_in){
 			pause_micros = getMicros() - start_stamp_micros;
 		}else{
 			start_stamp_micros = getMicros() - pause_micros;
+#ifdef TIMER_QUEUE
+			// the deadline has moved, so move the queue entry with it
+			if (scheduled && active) {
+				scheduled = timerqueue::add(this);
+			}
+#endif
 		}
 	}
 
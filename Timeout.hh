@@ -28,14 +28,21 @@
 /// Timeout objects maintain timestamps and check the universal clock to figure out when they've
 /// elapsed.  Resolution is at best that of the system interval.  Maximum timeout length is
 /// 4294967295 microseconds.
-/// Timeouts must be checked before the maximum timeout length to remain valid 
+/// Timeouts must be checked before the maximum timeout length to remain valid; use a
+/// #LongTimeout for anything longer.
 /// After a timeout has elapsed, it can not go back to a valid state without being explicitly reset.
+///
+/// Timeouts started with #schedule() instead of #start() are expired by the
+/// #timerqueue, so checking them does not read the clock.
 /// \ingroup SoftwareLibraries
 class Timeout {
 private:
         bool active;                    ///< True if the timeout object is actively counting down.
         bool elapsed;                   ///< True if the timeout object has elapsed.
         bool is_paused;					///< True if the timeout object is paused
+#ifdef TIMER_QUEUE
+        bool scheduled;                 ///< True if the timer queue will mark this timeout elapsed
+#endif
 
         //TODO: Instead of storing start and duration, precompute and store the elapse time.
 	micros_t start_stamp_micros;
@@ -49,6 +56,23 @@ public:
         /// \param [in] duration_micros Microseconds until the timeout cycle should elapse.
 	void start(micros_t duration_micros);
 
+        /// Start a new timeout cycle, like #start(), and hand it to the timer queue so
+        /// that #hasElapsed() only has to check a flag.  Without TIMER_QUEUE, or if the
+        /// queue is full, this is the same as #start().  The timeout must not be
+        /// destroyed while it is running.
+        /// \param [in] duration_micros Microseconds until the timeout cycle should elapse.
+	void schedule(micros_t duration_micros);
+
+        /// \return The time at which the current timeout cycle elapses
+	micros_t getDeadline() const { return start_stamp_micros + duration_micros; }
+
+#ifdef TIMER_QUEUE
+        /// Mark the timeout as elapsed if it is still waiting for the given deadline.
+        /// Called by the timer queue.
+        /// \param [in] deadline Deadline of the queue entry that has come due
+	void expire(micros_t deadline);
+#endif
+
         /// Test whether the current timeout cycle has elapsed. When called, this function will
         /// compare the system time to the calculated time that the timeout should expire, and
         /// if it has, the timer is marked as elapsed and not active.
@@ -0,0 +1,107 @@
+#include "TimerHeatingElement.hh"
+#include <avr/io.h>
+#include <util/atomic.h>
+
+/// Timer prescalers, indexed by clock select value less one
+static const uint16_t PRESCALERS[] = { 1, 8, 64, 256, 1024 };
+
+TimerHeatingElement::TimerHeatingElement(uint8_t timer, Channel channel, const Pin& pin_in, uint16_t frequency) :
+	tccra(0),
+	tccrb(0),
+	icr(0),
+	ocr(0),
+	// COMnA1, COMnB1 and COMnC1 are bits 7, 5 and 3
+	com_mask(_BV(7 - 2 * channel)),
+	pin(pin_in)
+{
+	switch (timer) {
+	case 1:
+		tccra = &TCCR1A; tccrb = &TCCR1B; icr = &ICR1; ocr = &OCR1A;
+		break;
+#ifdef TCCR3A
+	case 3:
+		tccra = &TCCR3A; tccrb = &TCCR3B; icr = &ICR3; ocr = &OCR3A;
+		break;
+#endif
+#ifdef TCCR4A
+	case 4:
+		tccra = &TCCR4A; tccrb = &TCCR4B; icr = &ICR4; ocr = &OCR4A;
+		break;
+#endif
+#ifdef TCCR5A
+	case 5:
+		tccra = &TCCR5A; tccrb = &TCCR5B; icr = &ICR5; ocr = &OCR5A;
+		break;
+#endif
+	}
+	// the compare registers of a timer follow each other
+	if (ocr) {
+		ocr += channel;
+	}
+
+	if (frequency == 0) {
+		frequency = 1;
+	}
+	// use the smallest prescaler that fits the period in 16 bits, to get the
+	// most duty cycle steps
+	uint32_t ticks = 0;
+	for (clock_select = 1; clock_select <= 5; clock_select++) {
+		ticks = F_CPU / ((uint32_t)PRESCALERS[clock_select - 1] * frequency);
+		if (ticks <= 0x10000) {
+			break;
+		}
+	}
+	if (clock_select > 5) {
+		clock_select = 5;
+		ticks = 0x10000;
+	}
+	if (ticks < 2) {
+		ticks = 2;
+	}
+	top = ticks - 1;
+}
+
+void TimerHeatingElement::init() {
+	pin.setValue(false);
+	pin.setDirection(true);
+	if (!tccra) {
+		return;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		// Fast PWM with ICRn as TOP (mode 14): WGMn3:0 = 1110
+		*tccra = (*tccra & ~(_BV(WGM11) | _BV(WGM10) | com_mask)) | _BV(WGM11);
+		*tccrb = _BV(WGM13) | _BV(WGM12) | clock_select;
+		*icr = top;
+		*ocr = 0;
+	}
+}
+
+void TimerHeatingElement::setHeatingElement(uint8_t value) {
+	// 255 * 257 is full on
+	setHeatingElementFine((uint16_t)value * 257);
+}
+
+void TimerHeatingElement::setHeatingElementFine(uint16_t value) {
+	if (!tccra) {
+		return;
+	}
+
+	// the output is high for ocr + 1 of every top + 1 ticks, so round the duty
+	// to the nearest number of high ticks and set ocr one less; 0xffff is
+	// full on whatever the period
+	uint32_t ticks = (uint32_t)top + 1;
+	if (value != 0xffff) {
+		ticks = ((uint32_t)value * ticks + 0x8000) >> 16;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (ticks == 0) {
+			// disconnect the channel, so the pin stays low
+			*tccra &= ~com_mask;
+		} else {
+			*ocr = ticks - 1;
+			*tccra |= com_mask;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef TIMER_HEATING_ELEMENT_HH_
+#define TIMER_HEATING_ELEMENT_HH_
+
+#include <stdint.h>
+#include "HeatingElement.hh"
+#include "Pin.hh"
+
+/// A heating element driven by a compare channel of one of the 16 bit timers,
+/// in fast PWM mode with the period set by the ICR register.  The period is
+/// chosen from the PWM frequency, and the duty cycle has as many steps as the
+/// period has timer ticks: at 16 MHz, 12 bits or more up to 3.9 kHz, and 10
+/// bits or more up to 15.6 kHz.  That lets a small hotend hold at a low duty
+/// without being stuck at steps of 1/255.
+///
+/// Channels of the same timer share its period, so they must be given the same
+/// frequency.  The duty is rounded to the nearest whole tick, and a duty that
+/// rounds to no ticks disconnects the channel, so the output is fully off
+/// rather than giving a one tick pulse.
+/// \ingroup HardwareLibraries
+class TimerHeatingElement : public HeatingElement {
+public:
+	/// Compare channel of the timer
+	enum Channel {
+		CHANNEL_A = 0,
+		CHANNEL_B = 1,
+		CHANNEL_C = 2,
+	};
+
+private:
+	volatile uint8_t* tccra;    ///< Timer control register A
+	volatile uint8_t* tccrb;    ///< Timer control register B
+	volatile uint16_t* icr;     ///< Input capture register, holding the period
+	volatile uint16_t* ocr;     ///< Output compare register of the channel
+	uint8_t com_mask;           ///< COMnx1 bit of the channel, in TCCRnA
+	uint8_t clock_select;       ///< CSn bits for the prescaler
+	uint16_t top;               ///< Timer period, less one
+	Pin pin;                    ///< Compare output pin of the channel
+
+public:
+	/// Create a heating element on a timer channel.  The timer is not touched
+	/// until #init() is called.
+	/// \param[in] timer Number of the 16 bit timer: 1, 3, 4 or 5 where the
+	///                  processor has them
+	/// \param[in] channel Compare channel of the timer
+	/// \param[in] pin Compare output pin of the channel (OCnx)
+	/// \param[in] frequency PWM frequency, in Hz
+	TimerHeatingElement(uint8_t timer, Channel channel, const Pin& pin, uint16_t frequency);
+
+	/// Set up the timer and pin, with the element off
+	void init();
+
+	void setHeatingElement(uint8_t value);
+
+	void setHeatingElementFine(uint16_t value);
+
+	/// \return Number of duty cycle steps, less one
+	uint16_t getTop() const { return top; }
+};
+
+#endif // TIMER_HEATING_ELEMENT_HH_
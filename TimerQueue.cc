@@ -0,0 +1,134 @@
+#include "TimerQueue.hh"
+#include "Timeout.hh"
+#include "Configuration.hh"
+
+#ifdef TIMER_QUEUE
+
+#if defined IS_EXTRUDER_BOARD
+    #include "ExtruderBoard.hh"
+
+	inline micros_t getMicros() { return ExtruderBoard::getBoard().getCurrentMicros(); }
+#else
+    #include "Motherboard.hh"
+
+    inline micros_t getMicros() { return Motherboard::getBoard().getCurrentMicros(); }
+#endif
+
+namespace timerqueue {
+
+struct Entry {
+	Timeout* timeout;
+	micros_t deadline;
+};
+
+Entry heap[TIMER_QUEUE_SIZE];
+uint8_t count = 0;
+
+/// Compare deadlines in a way that survives the clock wrapping
+inline bool before(micros_t a, micros_t b) {
+	return (int32_t)(a - b) < 0;
+}
+
+/// Place an entry at a hole in the heap, moving it towards the root while it
+/// is due before its parent
+static void siftUp(uint8_t i, const Entry& entry) {
+	while (i > 0) {
+		uint8_t parent = (i - 1) / 2;
+		if (!before(entry.deadline, heap[parent].deadline)) {
+			break;
+		}
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = entry;
+}
+
+/// Place an entry at a hole in the heap, moving it towards the leaves while a
+/// child is due before it
+static void siftDown(uint8_t i, const Entry& entry) {
+	while (true) {
+		uint8_t child = 2 * i + 1;
+		if (child >= count) {
+			break;
+		}
+		if (child + 1 < count && before(heap[child + 1].deadline, heap[child].deadline)) {
+			child++;
+		}
+		if (!before(heap[child].deadline, entry.deadline)) {
+			break;
+		}
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = entry;
+}
+
+/// Put an entry at a position in the heap, wherever its deadline belongs
+/// relative to the entries around it
+static void place(uint8_t i, const Entry& entry) {
+	if (i > 0 && before(entry.deadline, heap[(i - 1) / 2].deadline)) {
+		siftUp(i, entry);
+	} else {
+		siftDown(i, entry);
+	}
+}
+
+/// \return Position of the entry for a timeout, or count if it has none
+static uint8_t find(const Timeout* timeout) {
+	uint8_t i = 0;
+	while (i < count && heap[i].timeout != timeout) {
+		i++;
+	}
+	return i;
+}
+
+/// Remove the entry at a position, filling the hole with the last entry
+static void removeAt(uint8_t i) {
+	Entry last = heap[--count];
+	if (i < count) {
+		place(i, last);
+	}
+}
+
+bool add(Timeout* timeout) {
+	Entry entry;
+	entry.timeout = timeout;
+	entry.deadline = timeout->getDeadline();
+
+	// A timeout restarted before it came due reuses its entry
+	uint8_t i = find(timeout);
+	if (i < count) {
+		place(i, entry);
+		return true;
+	}
+
+	if (count >= TIMER_QUEUE_SIZE) {
+		return false;
+	}
+	siftUp(count++, entry);
+	return true;
+}
+
+void remove(const Timeout* timeout) {
+	uint8_t i = find(timeout);
+	if (i < count) {
+		removeAt(i);
+	}
+}
+
+void run() {
+	if (count == 0) {
+		return;
+	}
+
+	micros_t now = getMicros();
+	while (count > 0 && !before(now, heap[0].deadline)) {
+		Entry entry = heap[0];
+		removeAt(0);
+		entry.timeout->expire(entry.deadline);
+	}
+}
+
+} // namespace timerqueue
+
+#endif // TIMER_QUEUE
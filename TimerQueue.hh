@@ -0,0 +1,48 @@
+#ifndef TIMER_QUEUE_HH_
+#define TIMER_QUEUE_HH_
+
+#include <stdint.h>
+#include "Types.hh"
+
+class Timeout;
+
+/// Maximum number of timeouts that can be waiting in the queue
+#ifndef TIMER_QUEUE_SIZE
+#define TIMER_QUEUE_SIZE 16
+#endif
+
+/// The timer queue keeps the deadlines of scheduled #Timeout objects in a
+/// min-heap, so that a single clock read per main loop pass expires every
+/// timeout that is due, however many are waiting.  Scheduled timeouts then
+/// answer Timeout::hasElapsed() from a flag instead of reading the clock.
+/// The heaters schedule their sample and PID timeouts here, which are
+/// restarted every few hundred milliseconds for as long as the board runs.
+///
+/// The queue is only compiled in when TIMER_QUEUE is defined.  tasks::runSlice()
+/// then calls #run() on every main loop pass; a board whose main loop does not
+/// go through the task scheduler must call #run() itself.  Deadlines are ordered
+/// relative to each other, so scheduled durations must be shorter than
+/// 2^31 microseconds (about 35 minutes).
+namespace timerqueue {
+
+/// Add a timeout to the queue, or move its entry to its new deadline if it
+/// already has one, so that a timeout restarted every cycle only ever takes
+/// one entry.  The timeout must already be started, and must outlive its
+/// queue entry (members of board objects, not locals).
+/// \param[in] timeout Timeout to expire at its deadline
+/// \return False if the queue is full
+bool add(Timeout* timeout);
+
+/// Remove the entry for a timeout, if it has one.  Called when a scheduled
+/// timeout is restarted or aborted.
+/// \param[in] timeout Timeout to remove
+void remove(const Timeout* timeout);
+
+/// Mark every timeout whose deadline has passed as elapsed.  Entries for
+/// timeouts paused since they were added are discarded; the timeout is added
+/// again when it resumes.
+void run();
+
+}
+
+#endif // TIMER_QUEUE_HH_
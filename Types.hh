@@ -24,4 +24,11 @@
 /// Type used to store measurements of microseconds.
 typedef uint32_t micros_t;
 
+/// Type used to store microseconds that must not wrap, see #extendedclock.
+typedef uint64_t micros64_t;
+
+/// Number of fractional bits in fixed point temperatures, which count
+/// sixteenths of a degree Celsius.
+#define TEMPERATURE_FRACTION_BITS 4
+
 #endif // TYPES_HH_
@@ -18,7 +18,10 @@
 
 #include "UART.hh"
 #include "Pin.hh"
+#include "PacketLog.hh"
+#include "CircularBuffer.hh"
 #include <stdint.h>
+#include <util/atomic.h>
 #include <avr/sfr_defs.h>
 #include <avr/interrupt.h>
 #include <avr/io.h>
@@ -31,6 +34,18 @@
 #include "ExtruderBoard.hh"
 #endif
 
+#ifdef LINK_BENCHMARK
+#if defined IS_EXTRUDER_BOARD
+    #include "ExtruderBoard.hh"
+
+    inline micros_t getMicros() { return ExtruderBoard::getBoard().getCurrentMicros(); }
+#else
+    #include "Motherboard.hh"
+
+    inline micros_t getMicros() { return Motherboard::getBoard().getCurrentMicros(); }
+#endif
+#endif
+
 // Avoid repeatedly creating temp objects
 const Pin TX_Enable = TX_ENABLE_PIN;
 const Pin RX_Enable = RX_ENABLE_PIN;
@@ -39,6 +54,22 @@ const Pin RX_Enable = RX_ENABLE_PIN;
 // them from our receive buffer later.This is only used for RS485 mode.
 volatile uint8_t loopback_bytes = 0;
 
+#ifdef HOST_FLOW_CONTROL
+// With flow control, the host receive interrupt only queues bytes, and raises
+// RTS to ask the host to pause when the queue passes the high-water mark.  The
+// headroom above the mark covers bytes already in flight in the host's serial
+// adapter when it sees RTS change.
+#ifndef HOST_RX_BUFFER_SIZE
+#define HOST_RX_BUFFER_SIZE 64
+#endif
+#define HOST_RX_HIGH_WATER (HOST_RX_BUFFER_SIZE - 16)
+#define HOST_RX_LOW_WATER  (HOST_RX_BUFFER_SIZE / 4)
+
+const Pin RTS_Pin = HOST_RTS_PIN;
+
+DEFINE_BUFFER(host_rx_buffer, uint8_t, HOST_RX_BUFFER_SIZE);
+#endif
+
 // We support three platforms: Atmega168 (1 UART), Atmega644, and Atmega1280/2560
 #if defined (__AVR_ATmega168__)     \
     || defined (__AVR_ATmega328__)  \
@@ -171,6 +202,12 @@ UART::UART(uint8_t index, communication_mode mode) :
 
         init_serial();
 
+#ifdef SLAVE_BUS_FEC
+        // Error correction trailers are only used on the RS485 slave bus
+        in.setFec(mode == RS485);
+        out.setFec(mode == RS485);
+#endif
+
 }
 
 // Subsequent bytes will be triggered by the tx complete interrupt.
@@ -189,6 +226,14 @@ void UART::beginSend() {
 void UART::enable(bool enabled) {
         enabled_ = enabled;
         if (index_ == 0) {
+#ifdef HOST_FLOW_CONTROL
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                        host_rx_buffer.reset();
+                }
+                // RTS is active high: high asks the host to stop sending
+                RTS_Pin.setValue(false);
+                RTS_Pin.setDirection(true);
+#endif
                 if (enabled) { ENABLE_SERIAL_INTERRUPTS(0); }
                 else { DISABLE_SERIAL_INTERRUPTS(0); }
         }
@@ -219,6 +264,106 @@ void UART::reset() {
         }
 }
 
+#ifdef LINK_BENCHMARK
+// The resolution of these timestamps is that of the board clock, so the
+// interrupt time is only meaningful when summed over a whole packet.
+void UART::processTimedByte(uint8_t b) {
+        micros_t entry = getMicros();
+        if (!in.isStarted()) {
+                rx_start_micros = entry;
+                rx_isr_micros = 0;
+        }
+        in.processByte(b);
+        if (in.isFinished()) {
+                rx_end_micros = entry;
+        }
+        rx_isr_micros += getMicros() - entry;
+}
+
+void UART::appendEchoTiming(OutPacket& response) {
+        micros_t now = getMicros();
+
+        // The command byte and the host timestamp
+        if (in.getLength() < 5) {
+                response.append8(RC_PACKET_LENGTH);
+                return;
+        }
+        response.append8(RC_OK);
+
+        // Host timestamp, copied back so the host can compute the round trip
+        response.append32(in.read32(1));
+        response.append32(rx_start_micros);
+        response.append32(rx_end_micros);
+        response.append32(rx_isr_micros);
+        // Latency between packet completion and the command handler
+        response.append32(now - rx_end_micros);
+
+        while (response.getLength() < in.getLength()) {
+                response.append8(0);
+        }
+}
+#endif
+
+// Pass a byte received on the host UART to the packet layer
+inline void hostReceiveByte(uint8_t byte_in) {
+        UART& uart = UART::getHostUART();
+#ifdef PACKET_LOG
+        bool was_finished = uart.in.isFinished();
+#endif
+
+#ifdef LINK_BENCHMARK
+        uart.processTimedByte( byte_in );
+#else
+        uart.in.processByte( byte_in );
+#endif
+
+#ifdef PACKET_LOG
+        if (!was_finished && uart.in.isFinished()) {
+                packetlog::record(uart.in);
+        }
+#endif
+}
+
+#ifdef HOST_FLOW_CONTROL
+// Queue a byte received on the host UART for processReceived()
+inline void hostQueueByte(uint8_t byte_in) {
+        if (host_rx_buffer.getRemainingCapacity() == 0) {
+                // The host kept sending past RTS; the byte is lost and the
+                // packet it belonged to will fail its CRC.
+#ifdef PACKET_LOG
+                packetlog::countLostByte();
+#endif
+                return;
+        }
+        host_rx_buffer.push(byte_in);
+        if (host_rx_buffer.getLength() >= HOST_RX_HIGH_WATER) {
+                RTS_Pin.setValue(true);
+        }
+}
+
+void UART::processReceived() {
+        while (!in.isFinished()) {
+                uint8_t byte_in;
+                bool have_byte = false;
+
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                        if (!host_rx_buffer.isEmpty()) {
+                                byte_in = host_rx_buffer.pop();
+                                have_byte = true;
+                                if (host_rx_buffer.getLength() <= HOST_RX_LOW_WATER) {
+                                        RTS_Pin.setValue(false);
+                                }
+                        }
+                }
+
+                if (!have_byte) {
+                        break;
+                }
+                hostReceiveByte(byte_in);
+        }
+}
+#endif
+
 #if defined (__AVR_ATmega168__) || defined (__AVR_ATmega328__)
 
     // Send and receive interrupts
@@ -230,7 +375,7 @@ void UART::reset() {
             if (loopback_bytes > 0) {
                     loopback_bytes--;
             } else {
-                    UART::getHostUART().in.processByte( byte_in );
+                    hostReceiveByte( byte_in );
 
                     // Workaround for buggy hardware: have slave hold line high.
     #if ASSERT_LINE_FIX
@@ -258,7 +403,11 @@ void UART::reset() {
     // Send and receive interrupts
     ISR(USART0_RX_vect)
     {
-            UART::getHostUART().in.processByte( UDR0 );
+    #ifdef HOST_FLOW_CONTROL
+            hostQueueByte( UDR0 );
+    #else
+            hostReceiveByte( UDR0 );
+    #endif
     }
 
     ISR(USART0_TX_vect)
@@ -20,6 +20,7 @@
 
 #include "Packet.hh"
 #include "Configuration.hh"
+#include "Types.hh"
 #include <stdint.h>
 
 // TODO: Move to UART class
@@ -79,6 +80,12 @@ private:
         const uint8_t index_;               ///< Hardware UART index
         volatile bool enabled_;             ///< True if the hardware is currently enabled
 
+#ifdef LINK_BENCHMARK
+        volatile micros_t rx_start_micros;  ///< Time the start byte of #in was received
+        volatile micros_t rx_end_micros;    ///< Time the last byte of #in was received
+        volatile micros_t rx_isr_micros;    ///< Time spent in the RX interrupt for #in
+#endif
+
 public:
         InPacket in;                        ///< Input packet
         OutPacket out;                      ///< Output packet
@@ -93,6 +100,30 @@ public:
         /// Reset the UART to a listening state.  This is important for
         /// RS485-based comms.
         void reset();
+
+#ifdef HOST_FLOW_CONTROL
+        /// Feed bytes queued by the host receive interrupt to #in, releasing
+        /// the RTS line once the queue has drained below its low-water mark.
+        /// Stops when #in holds a finished packet, so that the following bytes
+        /// are kept for the next one.  With flow control enabled this must be
+        /// called regularly from the main loop, before #in is examined.
+        void processReceived();
+#endif
+
+#ifdef LINK_BENCHMARK
+        /// Pass a received byte to #in, recording when the packet started and
+        /// finished and how long the receive interrupt spent on it. Called from
+        /// the RX interrupt in place of InPacket::processByte().
+        /// \param[in] b Byte read from the hardware
+        void processTimedByte(uint8_t b);
+
+        /// Build the #HOST_CMD_DEBUG_ECHO_TIMED response for the packet held
+        /// in #in: RC_OK and the link timing report, padded so that the
+        /// response is as long as the request, or RC_PACKET_LENGTH alone if
+        /// the request is too short to hold the host timestamp.
+        /// \param[out] response Empty packet to append the response to
+        void appendEchoTiming(OutPacket& response);
+#endif
 };
 
 #endif // UART_HH_